@@ -0,0 +1,155 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ChunkyTriMesh.h"
+
+namespace MMAP
+{
+    void getSubTileBounds(rcConfig const& config, int x, int y, float* bmin, float* bmax)
+    {
+        bmin[0] = config.bmin[0] + (x * config.tileSize - config.borderSize) * config.cs;
+        bmin[2] = config.bmin[2] + (y * config.tileSize - config.borderSize) * config.cs;
+        bmax[0] = config.bmin[0] + ((x + 1) * config.tileSize + config.borderSize) * config.cs;
+        bmax[2] = config.bmin[2] + ((y + 1) * config.tileSize + config.borderSize) * config.cs;
+    }
+
+    ChunkyTriMesh::ChunkyTriMesh(float const* verts, int const* tris, int triCount, rcConfig const& config, int tilesPerMap)
+        : m_tilesPerMap(tilesPerMap), m_offsets(tilesPerMap * tilesPerMap + 1, 0)
+    {
+        std::vector<float> tileMin(2 * tilesPerMap * tilesPerMap), tileMax(2 * tilesPerMap * tilesPerMap);
+        for (int y = 0; y < tilesPerMap; ++y)
+        {
+            for (int x = 0; x < tilesPerMap; ++x)
+            {
+                float bmin[3], bmax[3];
+                getSubTileBounds(config, x, y, bmin, bmax);
+                int i = x + y * tilesPerMap;
+                tileMin[2 * i] = bmin[0];
+                tileMin[2 * i + 1] = bmin[2];
+                tileMax[2 * i] = bmax[0];
+                tileMax[2 * i + 1] = bmax[2];
+            }
+        }
+
+        // The border is narrower than a sub-tile, so a triangle can only reach
+        // one sub-tile beyond those its bounds fall into; the exact test below
+        // drops the candidates it does not overlap.
+        float const tileWidth = config.tileSize * config.cs;
+        std::vector<int> triTiles;
+        std::vector<int> triTileStart(triCount + 1, 0);
+        for (int t = 0; t < triCount; ++t)
+        {
+            triTileStart[t] = int(triTiles.size());
+            float const* v0 = &verts[tris[3 * t] * 3];
+            float const* v1 = &verts[tris[3 * t + 1] * 3];
+            float const* v2 = &verts[tris[3 * t + 2] * 3];
+            float minX = std::min(v0[0], std::min(v1[0], v2[0]));
+            float maxX = std::max(v0[0], std::max(v1[0], v2[0]));
+            float minZ = std::min(v0[2], std::min(v1[2], v2[2]));
+            float maxZ = std::max(v0[2], std::max(v1[2], v2[2]));
+
+            float fx0 = std::floor((minX - config.bmin[0]) / tileWidth) - 1.0f;
+            float fx1 = std::floor((maxX - config.bmin[0]) / tileWidth) + 1.0f;
+            float fy0 = std::floor((minZ - config.bmin[2]) / tileWidth) - 1.0f;
+            float fy1 = std::floor((maxZ - config.bmin[2]) / tileWidth) + 1.0f;
+            if (!(fx1 >= 0.0f && fy1 >= 0.0f && fx0 < tilesPerMap && fy0 < tilesPerMap))
+            {
+                continue;                                       // NaN or off the grid tile
+            }
+            int x0 = int(std::max(fx0, 0.0f));
+            int x1 = int(std::min(fx1, float(tilesPerMap - 1)));
+            int y0 = int(std::max(fy0, 0.0f));
+            int y1 = int(std::min(fy1, float(tilesPerMap - 1)));
+
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    int i = x + y * tilesPerMap;
+                    if (minX > tileMax[2 * i] || maxX < tileMin[2 * i] ||
+                        minZ > tileMax[2 * i + 1] || maxZ < tileMin[2 * i + 1])
+                    {
+                        continue;
+                    }
+                    triTiles.push_back(i);
+                    ++m_offsets[i + 1];
+                }
+            }
+        }
+        triTileStart[triCount] = int(triTiles.size());
+
+        for (size_t i = 1; i < m_offsets.size(); ++i)
+        {
+            m_offsets[i] += m_offsets[i - 1];
+        }
+
+        // Fill in mesh order, which keeps every list ascending
+        m_triangles.resize(triTiles.size());
+        std::vector<int> fill(m_offsets.begin(), m_offsets.end() - 1);
+        for (int t = 0; t < triCount; ++t)
+        {
+            for (int k = triTileStart[t]; k < triTileStart[t + 1]; ++k)
+            {
+                m_triangles[fill[triTiles[k]]++] = t;
+            }
+        }
+    }
+
+    int const* ChunkyTriMesh::getTriangles(int x, int y) const
+    {
+        int i = x + y * m_tilesPerMap;
+        return m_triangles.data() + m_offsets[i];
+    }
+
+    int ChunkyTriMesh::getTriangleCount(int x, int y) const
+    {
+        int i = x + y * m_tilesPerMap;
+        return m_offsets[i + 1] - m_offsets[i];
+    }
+
+    void ChunkyTriMesh::gather(int x, int y, int const* tris, unsigned char const* areas,
+        std::vector<int>& subTris, std::vector<unsigned char>& subAreas) const
+    {
+        int const* ids = getTriangles(x, y);
+        int count = getTriangleCount(x, y);
+        subTris.resize(3 * count);
+        for (int i = 0; i < count; ++i)
+        {
+            subTris[3 * i] = tris[3 * ids[i]];
+            subTris[3 * i + 1] = tris[3 * ids[i] + 1];
+            subTris[3 * i + 2] = tris[3 * ids[i] + 2];
+        }
+        if (areas)
+        {
+            subAreas.resize(count);
+            for (int i = 0; i < count; ++i)
+            {
+                subAreas[i] = areas[ids[i]];
+            }
+        }
+    }
+}
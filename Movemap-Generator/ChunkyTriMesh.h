@@ -0,0 +1,109 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MANGOS_H_CHUNKY_TRI_MESH
+#define MANGOS_H_CHUNKY_TRI_MESH
+
+#include <vector>
+
+#include <Recast.h>
+
+namespace MMAP
+{
+    /**
+     * @brief XZ bounds of a Recast sub-tile, border included
+     *
+     * buildMoveMapTile() sets up the sub-tile heightfields with these bounds,
+     * so the binning below tests triangles against exactly the same floats.
+     *
+     * @param config config of the whole grid tile
+     * @param x sub-tile column
+     * @param y sub-tile row
+     * @param bmin receives the lower corner; only [0] and [2] are set
+     * @param bmax receives the upper corner; only [0] and [2] are set
+     */
+    void getSubTileBounds(rcConfig const& config, int x, int y, float* bmin, float* bmax);
+
+    /**
+     * @brief Triangles of a mesh binned by the sub-tiles they may rasterize into
+     *
+     * A triangle is listed for every sub-tile whose border-padded XZ bounds
+     * its XZ bounds overlap, with the same inclusive test Recast uses to skip
+     * triangles outside a heightfield. Rasterizing only the listed triangles
+     * therefore gives the same spans as rasterizing the whole mesh. The lists
+     * keep the mesh order, so spans merge in the same order as well.
+     */
+    class ChunkyTriMesh
+    {
+        public:
+            /**
+             * @brief Bins the triangles, once per grid tile
+             *
+             * @param verts x, y, z of each vertex
+             * @param tris three vertex indices per triangle
+             * @param triCount
+             * @param config config of the whole grid tile
+             * @param tilesPerMap sub-tiles along each side of the grid tile
+             */
+            ChunkyTriMesh(float const* verts, int const* tris, int triCount, rcConfig const& config, int tilesPerMap);
+
+            /**
+             * @brief Indices of the triangles that may touch a sub-tile, ascending
+             *
+             * @param x sub-tile column
+             * @param y sub-tile row
+             * @return int const
+             */
+            int const* getTriangles(int x, int y) const;
+
+            /**
+             * @brief Number of triangles returned by getTriangles()
+             *
+             * @param x sub-tile column
+             * @param y sub-tile row
+             * @return int
+             */
+            int getTriangleCount(int x, int y) const;
+
+            /**
+             * @brief Copies the triangles of a sub-tile, and their area ids if given
+             *
+             * @param x sub-tile column
+             * @param y sub-tile row
+             * @param tris the triangles of the whole mesh
+             * @param areas the area ids of the whole mesh, or NULL
+             * @param subTris receives the vertex indices of the sub-tile's triangles
+             * @param subAreas receives their area ids, left alone if areas is NULL
+             */
+            void gather(int x, int y, int const* tris, unsigned char const* areas,
+                std::vector<int>& subTris, std::vector<unsigned char>& subAreas) const;
+
+        private:
+            int m_tilesPerMap;          /**< Sub-tiles along each side */
+            std::vector<int> m_offsets; /**< Start of each sub-tile's list in m_triangles, plus the end */
+            std::vector<int> m_triangles; /**< Triangle indices of all sub-tiles, one list after the other */
+    };
+}
+
+#endif
@@ -27,10 +27,13 @@
 
 #include "MMapCommon.h"
 #include "MapBuilder.h"
+#include "ChunkyTriMesh.h"
 
 #include "MapTree.h"
 #include "ModelInstance.h"
 #include "ExtractorCommon.h"
+#include "ExtractorTelemetry.h"
+#include "ExtractorTrace.h"
 
 using namespace VMAP;
 
@@ -49,13 +52,18 @@ namespace MMAP
         m_bigBaseUnit(bigBaseUnit),
         m_offMeshFilePath(offMeshFilePath),
         m_magic(magic),
-        m_threads(threads ? threads : std::thread::hardware_concurrency())
+        m_threads(threads ? threads : std::thread::hardware_concurrency()),
+        m_pool(NULL)
     {
         if (m_threads == 0)
         {
             m_threads = 1;  // fallback if hardware_concurrency() returns 0
         }
 
+        // A single thread gets a pool without workers, which runs every
+        // task inside submit() and so keeps the serial build order
+        m_pool = new WorkerPool(m_threads);
+
         m_terrainBuilder = new TerrainBuilder(skipLiquid);
 
         discoverTiles();
@@ -70,6 +78,7 @@ namespace MMAP
             delete(*it).second;
         }
 
+        delete m_pool;
         delete m_terrainBuilder;
     }
 
@@ -215,9 +224,12 @@ namespace MMAP
         {
             // Serial path. Preserved bit-for-bit so --threads 1 produces
             // the same output bytes as the pre-threading serial builds.
+            uint32 remaining = uint32(tiles->size());
+            addTelemetryWork(remaining);
             for (set<uint32>::iterator it = tiles->begin(); it != tiles->end(); ++it)
             {
                 uint32 tileX, tileY;
+                --remaining;
 
                 // unpack tile coords
                 StaticMapTree::unpackTileID((*it), tileX, tileY);
@@ -227,14 +239,16 @@ namespace MMAP
                     continue;
                 }
 
+                TelemetryTile tile(mapID, tileX, tileY, remaining);
                 buildTile(mapID, tileX, tileY, navMesh);
             }
         }
         else
         {
-            // Parallel path. The whole map's tile work is dropped on the
-            // queue before any worker starts, so workers can exit cleanly
-            // when they see an empty queue (no condvar/done-flag needed).
+            // Parallel path. Every tile is a task on the pool, and each tile
+            // hands its sub-tiles to the same pool (see buildMoveMapTile), so
+            // the workers keep busy on the last large tiles of a map too.
+            vector<uint32> pending;
             for (set<uint32>::iterator it = tiles->begin(); it != tiles->end(); ++it)
             {
                 uint32 tileX, tileY;
@@ -247,18 +261,64 @@ namespace MMAP
                     continue;
                 }
 
-                m_taskQueue.push(TileTask{ mapID, int(tileX), int(tileY) });
+                pending.push_back(*it);
             }
-
-            std::vector<std::thread> workers;
-            workers.reserve(m_threads);
-            for (unsigned int i = 0; i < m_threads; ++i)
+            addTelemetryWork(uint32(pending.size()));
+
+            // Each tile builds into a private navmesh initialized from the
+            // map navmesh's params. addTile() patches link arrays inside the
+            // tile data buffer, including external links to any neighbour tile
+            // resident in the same navmesh - sharing one navmesh would make
+            // the written .mmtile bytes depend on worker scheduling. A private
+            // navmesh keeps every tile built exactly as in the serial path
+            // (single resident tile) and needs no lock around add/removeTile.
+            // Finished tiles give theirs back for the next tile to use.
+            std::mutex navMeshLock;
+            vector<dtNavMesh*> idleNavMeshes;
+            std::atomic<uint32> queueDepth(uint32(pending.size()));
+            for (uint32 i = 0; i < pending.size(); ++i)
             {
-                workers.emplace_back(&MapBuilder::workerLoop, this, navMesh);
+                uint32 tileX, tileY;
+                StaticMapTree::unpackTileID(pending[i], tileX, tileY);
+
+                m_pool->submit([&, mapID, tileX, tileY]()
+                {
+                    uint32 depth = --queueDepth;
+                    dtNavMesh* tileNavMesh = NULL;
+                    {
+                        std::lock_guard<std::mutex> lock(navMeshLock);
+                        if (!idleNavMeshes.empty())
+                        {
+                            tileNavMesh = idleNavMeshes.back();
+                            idleNavMeshes.pop_back();
+                        }
+                    }
+                    if (!tileNavMesh)
+                    {
+                        tileNavMesh = dtAllocNavMesh();
+                        if (!tileNavMesh || dtStatusFailed(tileNavMesh->init(navMesh->getParams())))
+                        {
+                            printf("Failed creating per-tile navmesh! Skipping tile [%02u,%02u].    \n", tileX, tileY);
+                            dtFreeNavMesh(tileNavMesh);
+                            return;
+                        }
+                    }
+
+                    {
+                        TelemetryTile tile(mapID, tileX, tileY, depth);
+                        tile.splitAcrossWorkers();
+                        buildTile(mapID, tileX, tileY, tileNavMesh);
+                    }
+
+                    std::lock_guard<std::mutex> lock(navMeshLock);
+                    idleNavMeshes.push_back(tileNavMesh);
+                });
             }
-            for (std::thread& worker : workers)
+            m_pool->wait();
+
+            for (uint32 i = 0; i < idleNavMeshes.size(); ++i)
             {
-                worker.join();
+                dtFreeNavMesh(idleNavMeshes[i]);
             }
         }
 
@@ -267,43 +327,6 @@ namespace MMAP
         printf(" Map %04u complete!\n\n", mapID);
     }
 
-    /**************************************************************************/
-    void MapBuilder::workerLoop(dtNavMesh* navMesh)
-    {
-        // Each worker builds into a private navmesh initialized from the
-        // map navmesh's params. addTile() patches link arrays inside the
-        // tile data buffer, including external links to any neighbour tile
-        // resident in the same navmesh - sharing one navmesh would make
-        // the written .mmtile bytes depend on worker scheduling. A private
-        // navmesh keeps every tile built exactly as in the serial path
-        // (single resident tile) and needs no lock around add/removeTile.
-        dtNavMesh* workerNavMesh = dtAllocNavMesh();
-        if (!workerNavMesh || dtStatusFailed(workerNavMesh->init(navMesh->getParams())))
-        {
-            printf("Failed creating per-worker navmesh! Worker exiting.    \n");
-            dtFreeNavMesh(workerNavMesh);
-            return;
-        }
-
-        while (true)
-        {
-            TileTask task;
-            {
-                std::lock_guard<std::mutex> lock(m_queueMutex);
-                if (m_taskQueue.empty())
-                {
-                    break;
-                }
-                task = m_taskQueue.front();
-                m_taskQueue.pop();
-            }
-
-            buildTile(task.mapID, task.tileX, task.tileY, workerNavMesh);
-        }
-
-        dtFreeNavMesh(workerNavMesh);
-    }
-
     /**************************************************************************/
     void MapBuilder::buildSingleTile(int mapID, int tileX, int tileY)
     {
@@ -315,7 +338,15 @@ namespace MMAP
             return;
         }
 
-        buildTile(mapID, tileX, tileY, navMesh);
+        addTelemetryWork(1);
+        {
+            TelemetryTile tile(mapID, tileX, tileY, 0);
+            if (m_pool->getThreadCount())
+            {
+                tile.splitAcrossWorkers();
+            }
+            buildTile(mapID, tileX, tileY, navMesh);
+        }
         dtFreeNavMesh(navMesh);
     }
 
@@ -325,6 +356,7 @@ namespace MMAP
         MeshData meshData;
 
         // get heightmap data
+        TraceScope stage("load map");
         m_terrainBuilder->loadMap(mapID, tileX, tileY, meshData, m_magic);
 
         // get model data
@@ -332,6 +364,7 @@ namespace MMAP
         // opposite tile-coordinate order to map (.map) files, so loadVMap must be
         // called with tileY/tileX swapped relative to loadMap. Un-swapping this
         // (PR #35) caused WMO/building geometry to be silently skipped.
+        stage.next("load vmap");
         m_terrainBuilder->loadVMap(mapID, tileY, tileX, meshData);
 
         // if there is no data, give up now
@@ -341,6 +374,7 @@ namespace MMAP
         }
 
         // remove unused vertices
+        stage.next("prepare");
         TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
         TerrainBuilder::cleanVertices(meshData.liquidVerts, meshData.liquidTris);
 
@@ -361,6 +395,7 @@ namespace MMAP
         m_terrainBuilder->loadOffMeshConnections(mapID, tileX, tileY, meshData, m_offMeshFilePath);
 
         printf(" Building map %04u - Tile [%02u,%02u]\n", mapID, tileX, tileY);
+        stage.next("build");
         buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMesh);
     }
 
@@ -552,114 +587,148 @@ namespace MMAP
         // allocate subregions : tiles
         Tile* tiles = new Tile[TILES_PER_MAP * TILES_PER_MAP];
 
-        // Initialize per tile config.
-        rcConfig tileCfg;
-        memcpy(&tileCfg, &config, sizeof(rcConfig));
-        tileCfg.width = config.tileSize + config.borderSize * 2;
-        tileCfg.height = config.tileSize + config.borderSize * 2;
-
-        // build all tiles
-        for (int y = 0; y < TILES_PER_MAP; ++y)
-        {
-            for (int x = 0; x < TILES_PER_MAP; ++x)
+        // Bin the triangles by sub-tile once, so every sub-tile only rasterizes
+        // the triangles that can reach it instead of the whole grid tile
+        ChunkyTriMesh solidChunks(tVerts, tTris, tTriCount, config, TILES_PER_MAP);
+        ChunkyTriMesh liquidChunks(lVerts, lTris, lTriCount, config, TILES_PER_MAP);
+
+        // Sub-tiles share nothing but read-only input until the merge, so each
+        // one is built with its own rcContext, config and triangle buffers
+        auto buildSubTile = [&](int x, int y)
+        {
+            TelemetrySubTask subTask;
+            rcContext subCtx(false);
+            std::vector<int> subTris;
+            std::vector<unsigned char> subFlags;
+
+            // Initialize per tile config.
+            rcConfig tileCfg;
+            memcpy(&tileCfg, &config, sizeof(rcConfig));
+            tileCfg.width = config.tileSize + config.borderSize * 2;
+            tileCfg.height = config.tileSize + config.borderSize * 2;
+
+            Tile& tile = tiles[x + y * TILES_PER_MAP];
+
+            // Calculate the per tile bounding box.
+            getSubTileBounds(config, x, y, tileCfg.bmin, tileCfg.bmax);
+
+            float tbmin[2], tbmax[2];
+            tbmin[0] = tileCfg.bmin[0];
+            tbmin[1] = tileCfg.bmin[2];
+            tbmax[0] = tileCfg.bmax[0];
+            tbmax[1] = tileCfg.bmax[2];
+
+            // build heightfield
+            TraceScope stage("rasterize");
+            tile.solid = rcAllocHeightfield();
+            if (!tile.solid || !rcCreateHeightfield(&subCtx, *tile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
             {
-                Tile& tile = tiles[x + y * TILES_PER_MAP];
+                printf("%s Failed building heightfield!            \n", tileString);
+                return;
+            }
 
-                // Calculate the per tile bounding box.
-                tileCfg.bmin[0] = config.bmin[0] + (x * config.tileSize - config.borderSize) * config.cs;
-                tileCfg.bmin[2] = config.bmin[2] + (y * config.tileSize - config.borderSize) * config.cs;
-                tileCfg.bmax[0] = config.bmin[0] + ((x + 1) * config.tileSize + config.borderSize) * config.cs;
-                tileCfg.bmax[2] = config.bmin[2] + ((y + 1) * config.tileSize + config.borderSize) * config.cs;
-
-                float tbmin[2], tbmax[2];
-                tbmin[0] = tileCfg.bmin[0];
-                tbmin[1] = tileCfg.bmin[2];
-                tbmax[0] = tileCfg.bmax[0];
-                tbmax[1] = tileCfg.bmax[2];
-
-                // build heightfield
-                tile.solid = rcAllocHeightfield();
-                if (!tile.solid || !rcCreateHeightfield(&rcCtx, *tile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
-                {
-                    printf("%s Failed building heightfield!            \n", tileString);
-                    continue;
-                }
+            // mark all walkable tiles, both liquids and solids
+            solidChunks.gather(x, y, tTris, NULL, subTris, subFlags);
+            int subTriCount = int(subTris.size() / 3);
+            subFlags.assign(subTriCount, NAV_GROUND);
+            if (subTriCount)
+            {
+                rcClearUnwalkableTriangles(&subCtx, tileCfg.walkableSlopeAngle, tVerts, tVertCount, &subTris[0], subTriCount, &subFlags[0]);
+                rcRasterizeTriangles(&subCtx, tVerts, tVertCount, &subTris[0], &subFlags[0], subTriCount, *tile.solid, config.walkableClimb);
+            }
 
-                // mark all walkable tiles, both liquids and solids
-                unsigned char* triFlags = new unsigned char[tTriCount];
-                memset(triFlags, NAV_GROUND, tTriCount * sizeof(unsigned char));
-                rcClearUnwalkableTriangles(&rcCtx, tileCfg.walkableSlopeAngle, tVerts, tVertCount, tTris, tTriCount, triFlags);
-                rcRasterizeTriangles(&rcCtx, tVerts, tVertCount, tTris, triFlags, tTriCount, *tile.solid, config.walkableClimb);
-                delete [] triFlags;
+            rcFilterLowHangingWalkableObstacles(&subCtx, config.walkableClimb, *tile.solid);
+            rcFilterLedgeSpans(&subCtx, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid);
+            rcFilterWalkableLowHeightSpans(&subCtx, tileCfg.walkableHeight, *tile.solid);
 
-                rcFilterLowHangingWalkableObstacles(&rcCtx, config.walkableClimb, *tile.solid);
-                rcFilterLedgeSpans(&rcCtx, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid);
-                rcFilterWalkableLowHeightSpans(&rcCtx, tileCfg.walkableHeight, *tile.solid);
+            liquidChunks.gather(x, y, lTris, lTriFlags, subTris, subFlags);
+            subTriCount = int(subTris.size() / 3);
+            if (subTriCount)
+            {
+                rcRasterizeTriangles(&subCtx, lVerts, lVertCount, &subTris[0], &subFlags[0], subTriCount, *tile.solid, config.walkableClimb);
+            }
 
-                rcRasterizeTriangles(&rcCtx, lVerts, lVertCount, lTris, lTriFlags, lTriCount, *tile.solid, config.walkableClimb);
+            // compact heightfield spans
+            stage.next("compact");
+            tile.chf = rcAllocCompactHeightfield();
+            if (!tile.chf || !rcBuildCompactHeightfield(&subCtx, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid, *tile.chf))
+            {
+                printf("%s Failed compacting heightfield!            \n", tileString);
+                return;
+            }
 
-                // compact heightfield spans
-                tile.chf = rcAllocCompactHeightfield();
-                if (!tile.chf || !rcBuildCompactHeightfield(&rcCtx, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid, *tile.chf))
-                {
-                    printf("%s Failed compacting heightfield!            \n", tileString);
-                    continue;
-                }
+            // build polymesh intermediates
+            stage.next("regions");
+            if (!rcErodeWalkableArea(&subCtx, config.walkableRadius, *tile.chf))
+            {
+                printf("%s Failed eroding area!                    \n", tileString);
+                return;
+            }
 
-                // build polymesh intermediates
-                if (!rcErodeWalkableArea(&rcCtx, config.walkableRadius, *tile.chf))
-                {
-                    printf("%s Failed eroding area!                    \n", tileString);
-                    continue;
-                }
+            if (!rcBuildDistanceField(&subCtx, *tile.chf))
+            {
+                printf("%s Failed building distance field!         \n", tileString);
+                return;
+            }
 
-                if (!rcBuildDistanceField(&rcCtx, *tile.chf))
-                {
-                    printf("%s Failed building distance field!         \n", tileString);
-                    continue;
-                }
+            if (!rcBuildRegions(&subCtx, *tile.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
+            {
+                printf("%s Failed building regions!                \n", tileString);
+                return;
+            }
 
-                if (!rcBuildRegions(&rcCtx, *tile.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
-                {
-                    printf("%s Failed building regions!                \n", tileString);
-                    continue;
-                }
+            stage.next("contours");
+            tile.cset = rcAllocContourSet();
+            if (!tile.cset || !rcBuildContours(&subCtx, *tile.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
+            {
+                printf("%s Failed building contours!               \n", tileString);
+                return;
+            }
 
-                tile.cset = rcAllocContourSet();
-                if (!tile.cset || !rcBuildContours(&rcCtx, *tile.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
-                {
-                    printf("%s Failed building contours!               \n", tileString);
-                    continue;
-                }
+            // build polymesh
+            stage.next("polymesh");
+            tile.pmesh = rcAllocPolyMesh();
+            if (!tile.pmesh || !rcBuildPolyMesh(&subCtx, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
+            {
+                printf("%s Failed building polymesh!               \n", tileString);
+                return;
+            }
 
-                // build polymesh
-                tile.pmesh = rcAllocPolyMesh();
-                if (!tile.pmesh || !rcBuildPolyMesh(&rcCtx, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
-                {
-                    printf("%s Failed building polymesh!               \n", tileString);
-                    continue;
-                }
+            stage.next("detail");
+            tile.dmesh = rcAllocPolyMeshDetail();
+            if (!tile.dmesh || !rcBuildPolyMeshDetail(&subCtx, *tile.pmesh, *tile.chf, tileCfg.detailSampleDist, tileCfg    .detailSampleMaxError, *tile.dmesh))
+            {
+                printf("%s Failed building polymesh detail!        \n", tileString);
+                return;
+            }
 
-                tile.dmesh = rcAllocPolyMeshDetail();
-                if (!tile.dmesh || !rcBuildPolyMeshDetail(&rcCtx, *tile.pmesh, *tile.chf, tileCfg.detailSampleDist, tileCfg    .detailSampleMaxError, *tile.dmesh))
-                {
-                    printf("%s Failed building polymesh detail!        \n", tileString);
-                    continue;
-                }
+            // free those up
+            // we may want to keep them in the future for debug
+            // but right now, we don't have the code to merge them
+            rcFreeHeightField(tile.solid);
+            tile.solid = NULL;
+            rcFreeCompactHeightfield(tile.chf);
+            tile.chf = NULL;
+            rcFreeContourSet(tile.cset);
+            tile.cset = NULL;
+        };
 
-                // free those up
-                // we may want to keep them in the future for debug
-                // but right now, we don't have the code to merge them
-                rcFreeHeightField(tile.solid);
-                tile.solid = NULL;
-                rcFreeCompactHeightfield(tile.chf);
-                tile.chf = NULL;
-                rcFreeContourSet(tile.cset);
-                tile.cset = NULL;
+        // build all tiles
+        // They run as one group on the pool, nested under the tile's own task.
+        // The merge below takes them in y/x order whatever order they finish
+        // in, so the output is the same for every thread count.
+        WorkerPool::TaskGroup subTiles;
+        for (int y = 0; y < TILES_PER_MAP; ++y)
+        {
+            for (int x = 0; x < TILES_PER_MAP; ++x)
+            {
+                m_pool->submit([&buildSubTile, x, y]() { buildSubTile(x, y); }, subTiles);
             }
         }
+        m_pool->wait(subTiles);
 
         // merge per tile poly and detail meshes
+        TraceScope stage("merge");
         rcPolyMesh** pmmerge = new rcPolyMesh*[TILES_PER_MAP * TILES_PER_MAP];
         if (!pmmerge)
         {
@@ -740,6 +809,7 @@ namespace MMAP
         }
 
         // setup mesh parameters
+        stage.next("navmesh data");
         dtNavMeshCreateParams params;
         memset(&params, 0, sizeof(params));
         params.verts = iv.polyMesh->verts;
@@ -833,6 +903,7 @@ namespace MMAP
             }
 
             // file output
+            stage.next("write");
             char fileName[255];
             sprintf(fileName, "mmaps/%04u%02i%02i.mmtile", mapID, tileX, tileY);
             FILE* file = fopen(fileName, "wb");
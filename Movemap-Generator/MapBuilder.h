@@ -29,7 +29,6 @@
 #include <set>
 #include <map>
 #include <mutex>
-#include <queue>
 #include <thread>
 
 #include <Recast.h>
@@ -37,6 +36,7 @@
 
 #include "TerrainBuilder.h"
 #include "IntermediateValues.h"
+#include "WorkerPool.h"
 
 #include "IVMapManager.h"
 #include "WorldModel.h"
@@ -230,23 +230,6 @@ namespace MMAP
              */
             bool shouldSkipTile(int mapID, int tileX, int tileY);
 
-            /**
-             * @brief Per-thread worker body for parallel buildMap path. Pops
-             * TileTasks off the shared queue until empty, building each tile
-             * into a private navmesh cloned from the map navmesh's params.
-             */
-            void workerLoop(dtNavMesh* navMesh);
-
-            /**
-             * @brief A single tile-build unit handed to a worker.
-             */
-            struct TileTask
-            {
-                int mapID;
-                int tileX;
-                int tileY;
-            };
-
             TerrainBuilder* m_terrainBuilder; /**< TODO */
             TileList m_tiles; /**< TODO */
 
@@ -262,8 +245,7 @@ namespace MMAP
             char const* m_magic;
 
             unsigned int m_threads;        ///< worker count for parallel buildMap; 1 == serial
-            std::mutex m_queueMutex;       ///< guards m_taskQueue
-            std::queue<TileTask> m_taskQueue;
+            WorkerPool* m_pool;            ///< runs the tiles of a map and the sub-tiles of each tile
             std::mutex m_debugOutputMutex; ///< serializes --debugOutput writes to the shared per-map marker file
     };
 }
@@ -25,8 +25,11 @@
 #include "MMapCommon.h"
 #include "MapBuilder.h"
 #include "ExtractorCommon.h"
+#include "ExtractorTelemetry.h"
+#include "ExtractorTrace.h"
 
 #include <chrono>
+#include <memory>
 
 using namespace MMAP;
 
@@ -86,6 +89,8 @@ void printUsage(char* prg)
     printf("   --debugOutput [true|false]        create debugging files for use with\n");
     printf("                                     RecastDemo.\n");
     printf("   --silent                          No questions asked.\n");
+    printTelemetryUsage();
+    printTraceUsage();
     printf("   [#]                               Build only the map specified by #.\n");
     printf("\n");
     printf(" Examples:\n");
@@ -114,6 +119,7 @@ bool handleArgs(int argc, char** argv,
     char*& offMeshInputPath)
 {
     char* param = NULL;
+    bool telemetryOk = true;
     for (int i = 1; i < argc; ++i)
     {
         if (strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--input") == 0)
@@ -335,6 +341,13 @@ bool handleArgs(int argc, char** argv,
 
             offMeshInputPath = param;
         }
+        else if (handleTelemetryArgs(argc, argv, i, telemetryOk) || handleTraceArgs(argc, argv, i, telemetryOk))
+        {
+            if (!telemetryOk)
+            {
+                return false;
+            }
+        }
         else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
         {
             printUsage(argv[0]);
@@ -365,6 +378,18 @@ int finish(const char* message, int returnValue)
     return returnValue;
 }
 
+// Recast and Detour allocate through malloc, not operator new; route them
+// through the accounting so --telemetry-memory sees the navmesh build.
+static void* recastAlloc(size_t size, rcAllocHint /*hint*/)
+{
+    return accountedMalloc(size);
+}
+
+static void* detourAlloc(size_t size, dtAllocHint /*hint*/)
+{
+    return accountedMalloc(size);
+}
+
 int main(int argc, char** argv)
 {
     char map_magic[16];
@@ -420,27 +445,47 @@ int main(int argc, char** argv)
         return silent ? -3 : finish(" Press any key to close...", -3);
     }
 
-    MapBuilder builder(map_magic, maxAngle, skipLiquid, skipContinents, skipJunkMaps,
-        skipBattlegrounds, debugOutput, bigBaseUnit, offMeshInputPath, num_threads);
+    initTelemetry("mmap-extractor");
+    initTrace();
+    if (isMemoryAccountingEnabled())
+    {
+        rcAllocSetCustom(recastAlloc, accountedFree);
+        dtAllocSetCustom(detourAlloc, accountedFree);
+    }
 
-    const auto buildStart = std::chrono::steady_clock::now();
-    if (tileX > -1 && tileY > -1 && mapnum >= 0)
+    // Built inside the discover phase, which times the tile discovery
+    std::unique_ptr<MapBuilder> builder;
     {
-        builder.buildSingleTile(mapnum, tileX, tileY);
+        TelemetryPhase phase("discover");
+        builder.reset(new MapBuilder(map_magic, maxAngle, skipLiquid, skipContinents, skipJunkMaps,
+            skipBattlegrounds, debugOutput, bigBaseUnit, offMeshInputPath, num_threads));
     }
-    else
+
+    const auto buildStart = std::chrono::steady_clock::now();
     {
-        if (mapnum >= 0)
+        TelemetryPhase phase("build");
+        if (tileX > -1 && tileY > -1 && mapnum >= 0)
         {
-            builder.buildMap(mapnum);
+            builder->buildSingleTile(mapnum, tileX, tileY);
         }
         else
         {
-            builder.buildAllMaps();
+            if (mapnum >= 0)
+            {
+                builder->buildMap(mapnum);
+            }
+            else
+            {
+                builder->buildAllMaps();
+            }
         }
     }
     const auto elapsedSec = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::steady_clock::now() - buildStart).count();
+    builder.reset();
+
+    shutdownTelemetry();
+    writeTrace();
     printf(" \n Total build time: %lld seconds\n\n", static_cast<long long>(elapsedSec));
 
     return silent ? 1 : finish(" Movemap build is complete! Press enter to exit\n", 1);
@@ -0,0 +1,102 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef DBCSTRUCTURE_H
+#define DBCSTRUCTURE_H
+
+#include <cstddef>
+#include "loadlib.h"
+
+/**
+ * Record layouts of the client databases the extractors read, for use with
+ * DBCTable. Each struct only lists the leading fields that are used; string
+ * fields hold an offset into the string table (DBCTable::getString). The
+ * static_asserts pin every member to its field index so a misplaced member
+ * fails the build instead of reading the wrong column.
+ */
+
+#define DBC_FIELD_INDEX(entry, member, index) \
+    static_assert(offsetof(entry, member) == (index) * sizeof(uint32), #entry "::" #member " must be field " #index)
+
+/**
+ * @brief Map.dbc
+ *
+ */
+struct MapEntry
+{
+    uint32 ID;              /**< Map id */
+    uint32 InternalName;    /**< String offset of the directory name of the map */
+};
+
+DBC_FIELD_INDEX(MapEntry, ID, 0);
+DBC_FIELD_INDEX(MapEntry, InternalName, 1);
+
+/**
+ * @brief AreaTable.dbc
+ *
+ */
+struct AreaTableEntry
+{
+    uint32 ID;              /**< Area id, as stored in the ADT chunks */
+    uint32 MapID;           /**< Map of the area */
+    uint32 ParentAreaID;    /**< Zone of the area, 0 for zones */
+    uint32 ExploreFlag;     /**< Exploration bit, written into the .map area grid */
+};
+
+DBC_FIELD_INDEX(AreaTableEntry, ID, 0);
+DBC_FIELD_INDEX(AreaTableEntry, MapID, 1);
+DBC_FIELD_INDEX(AreaTableEntry, ParentAreaID, 2);
+DBC_FIELD_INDEX(AreaTableEntry, ExploreFlag, 3);
+
+/**
+ * @brief LiquidType.dbc
+ *
+ */
+struct LiquidTypeEntry
+{
+    uint32 ID;              /**< Liquid type id, as stored in MCLQ/MH2O and WMO groups */
+    uint32 Name;            /**< String offset of the name */
+    uint32 Flags;           /**< Liquid flags */
+    uint32 Type;            /**< Basic liquid type: water, ocean, magma or slime */
+};
+
+DBC_FIELD_INDEX(LiquidTypeEntry, ID, 0);
+DBC_FIELD_INDEX(LiquidTypeEntry, Name, 1);
+DBC_FIELD_INDEX(LiquidTypeEntry, Flags, 2);
+DBC_FIELD_INDEX(LiquidTypeEntry, Type, 3);
+
+/**
+ * @brief GameObjectDisplayInfo.dbc
+ *
+ */
+struct GameObjectDisplayInfoEntry
+{
+    uint32 ID;              /**< Display id */
+    uint32 ModelName;       /**< String offset of the model path */
+};
+
+DBC_FIELD_INDEX(GameObjectDisplayInfoEntry, ID, 0);
+DBC_FIELD_INDEX(GameObjectDisplayInfoEntry, ModelName, 1);
+
+#endif
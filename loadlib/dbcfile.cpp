@@ -0,0 +1,228 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include "dbcfile.h"
+#undef min
+#undef max
+#include <mpq.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    /// Leading fields shared by the WDBC and WDB2 headers
+    struct DBCHeader
+    {
+        char magic[4];
+        uint32 recordCount;
+        uint32 fieldCount;
+        uint32 recordSize;
+        uint32 stringSize;
+    };
+
+    /// Fields the WDB2 header adds after DBCHeader
+    struct DB2HeaderExtra
+    {
+        uint32 tableHash;
+        uint32 build;
+        uint32 timestamp;
+        uint32 minId;
+        uint32 maxId;
+        uint32 locale;
+        uint32 copyTableSize;
+    };
+}
+
+DBCFile::DBCFile(const std::string& filename)
+    : filename(filename),
+    data(0),
+    records(0),
+    stringTable(0),
+    maxId(0),
+    hashMask(0)
+{
+
+}
+
+DBCFile::DBCFile(HANDLE file) : fileHandle(file), data(0), records(0), stringTable(0), maxId(0), hashMask(0)
+{
+
+}
+
+bool DBCFile::open()
+{
+    DWORD hi = 0;
+    size_t fileSize = SFileGetFileSize(fileHandle, &hi);
+    if (fileSize == SFILE_INVALID_SIZE || hi || fileSize < sizeof(DBCHeader))
+    {
+        SFileCloseFile(fileHandle);
+        printf("Could not read header in DBCFile %s. err=%u\n", filename.c_str(), GetLastError());
+        return false;
+    }
+
+    // One read for header, records and strings; everything below works in place
+    data = new unsigned char[fileSize];
+    if (!SFileReadFile(fileHandle, data, fileSize, NULL, NULL))
+    {
+        SFileCloseFile(fileHandle);
+        printf("DBCFile %s did not contain expected amount of data for records.\n", filename.c_str());
+        return false;
+    }
+    SFileCloseFile(fileHandle);
+
+    DBCHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t headerSize = sizeof(DBCHeader);
+
+    if (!memcmp(header.magic, "WDB2", 4))
+    {
+        DB2HeaderExtra extra;
+        if (fileSize < headerSize + sizeof(extra))
+        {
+            printf("Could not read header in DBCFile %s.\n", filename.c_str());
+            return false;
+        }
+        memcpy(&extra, data + headerSize, sizeof(extra));
+        headerSize += sizeof(extra);
+
+        // Later WDB2 files carry an ID index and a string length table that
+        // the reader does not need
+        if (extra.build > 12880 && extra.maxId)
+        {
+            if (extra.maxId < extra.minId)
+            {
+                printf("The ID range in DBCFile %s is invalid.\n", filename.c_str());
+                return false;
+            }
+            headerSize += size_t(extra.maxId - extra.minId + 1) * (sizeof(uint32) + sizeof(uint16));
+        }
+    }
+    else if (memcmp(header.magic, "WDBC", 4))
+    {
+        printf("The header in DBCFile %s did not match.\n", filename.c_str());
+        return false;
+    }
+    else if (header.fieldCount * 4 != header.recordSize)
+    {
+        printf("Field count and record size in DBCFile %s do not match.\n", filename.c_str());
+        return false;
+    }
+
+    recordSize = header.recordSize;
+    recordCount = header.recordCount;
+    fieldCount = header.fieldCount;
+    stringSize = header.stringSize;
+
+    if (headerSize + recordSize * recordCount + stringSize > fileSize)
+    {
+        printf("DBCFile %s did not contain expected amount of data for records.\n", filename.c_str());
+        return false;
+    }
+
+    records = data + headerSize;
+    stringTable = records + recordSize * recordCount;
+    buildIdIndex();
+    return true;
+}
+
+void DBCFile::buildIdIndex()
+{
+    // Plain strided reduction over field 0, no Record objects in the loop
+    maxId = 0;
+    const unsigned char* record = records;
+    for (size_t i = 0; i < recordCount; ++i, record += recordSize)
+    {
+        uint32 id;
+        memcpy(&id, record, sizeof(id));
+        maxId = id > maxId ? id : maxId;
+    }
+
+    if (!recordCount)
+    {
+        return;
+    }
+
+    // Client IDs are mostly dense and start near 1; only fall back to hashing
+    // when a direct table would be mostly holes
+    if (maxId < 4 * recordCount + 256)
+    {
+        denseIndex.assign(size_t(maxId) + 1, -1);
+        record = records;
+        for (size_t i = 0; i < recordCount; ++i, record += recordSize)
+        {
+            uint32 id;
+            memcpy(&id, record, sizeof(id));
+            denseIndex[id] = int32(i);
+        }
+        return;
+    }
+
+    uint32 size = 16;
+    while (size < 2 * recordCount)
+    {
+        size <<= 1;
+    }
+    hashMask = size - 1;
+    hashIds.assign(size, 0);
+    hashRows.assign(size, -1);
+
+    record = records;
+    for (size_t i = 0; i < recordCount; ++i, record += recordSize)
+    {
+        uint32 id;
+        memcpy(&id, record, sizeof(id));
+
+        uint32 slot = hashSlot(id);
+        while (hashRows[slot] >= 0 && hashIds[slot] != id)
+        {
+            slot = (slot + 1) & hashMask;
+        }
+        hashIds[slot] = id;
+        hashRows[slot] = int32(i);
+    }
+}
+
+DBCFile::~DBCFile()
+{
+    delete [] data;
+}
+
+DBCFile::Record DBCFile::getRecord(size_t id)
+{
+    assert(records);
+    return Record(*this, records + id * recordSize);
+}
+
+DBCFile::Iterator DBCFile::begin()
+{
+    assert(records);
+    return Iterator(*this, records);
+}
+
+DBCFile::Iterator DBCFile::end()
+{
+    assert(records);
+    return Iterator(*this, stringTable);
+}
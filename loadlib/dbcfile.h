@@ -26,12 +26,21 @@
 #define DBCFILE_H
 
 #include <cassert>
+#include <cstddef>
 #include <string>
+#include <vector>
 #include "StormLib.h"
+#include "loadlib.h"
 
 /**
- * @brief
+ * @brief Client database reader for WDBC (.dbc) and WDB2 (.db2) files
  *
+ * The whole file is read with a single call into one buffer; records and the
+ * string table are used in place. Besides the untyped Record accessors the
+ * records can be viewed through the schemas of DBCStructure.h, see DBCTable.
+ * While opening, an index on field 0 (the ID) is built so findById() is
+ * constant time: a direct table when the IDs are compact, an open addressing
+ * hash table otherwise.
  */
 class DBCFile
 {
@@ -53,6 +62,8 @@ class DBCFile
         /**
          * @brief Open database. It must be openened before it can be used.
          *
+         * The file handle is closed, whether or not the file could be read.
+         *
          * @return bool
          */
         bool open();
@@ -311,20 +322,177 @@ class DBCFile
         size_t getFieldCount() const { return fieldCount; }
 
         /**
-         * @brief
+         * @brief Size of one record in bytes
+         *
+         * @return size_t
+         */
+        size_t getRecordSize() const { return recordSize; }
+
+        /**
+         * @brief Highest ID, computed while opening
          *
          * @return size_t
          */
-        size_t getMaxId();
+        size_t getMaxId() const { return maxId; }
+
+        /**
+         * @brief Record with the given ID; for duplicate IDs the last one wins
+         *
+         * @param id
+         * @return const unsigned char start of the record, NULL if there is none
+         */
+        const unsigned char* findById(uint32 id) const
+        {
+            int32 row = -1;
+            if (!denseIndex.empty())
+            {
+                if (id < denseIndex.size())
+                {
+                    row = denseIndex[id];
+                }
+            }
+            else if (!hashRows.empty())
+            {
+                for (uint32 slot = hashSlot(id); hashRows[slot] >= 0; slot = (slot + 1) & hashMask)
+                {
+                    if (hashIds[slot] == id)
+                    {
+                        row = hashRows[slot];
+                        break;
+                    }
+                }
+            }
+            return row < 0 ? NULL : records + size_t(row) * recordSize;
+        }
+
+        /**
+         * @brief Start of the first record
+         *
+         * @return const unsigned char
+         */
+        const unsigned char* getRecordData() const { return records; }
+
+        /**
+         * @brief String at the given offset of the string table
+         *
+         * @param stringOffset a string field value
+         * @return const char
+         */
+        const char* getStringAt(uint32 stringOffset) const
+        {
+            assert(stringOffset < stringSize);
+            return reinterpret_cast<const char*>(stringTable + stringOffset);
+        }
+
     private:
+        /**
+         * @brief Builds the ID index and maxId, called once the records are in place
+         *
+         */
+        void buildIdIndex();
+
+        /**
+         * @brief Home slot of an ID in the hash index
+         *
+         * @param id
+         * @return uint32
+         */
+        uint32 hashSlot(uint32 id) const
+        {
+            id = (id ^ (id >> 16)) * 0x45d9f3bu;
+            return (id ^ (id >> 16)) & hashMask;
+        }
+
         std::string filename; /**< TODO */
         HANDLE fileHandle; /**< TODO */
         size_t recordSize; /**< TODO */
         size_t recordCount; /**< TODO */
         size_t fieldCount; /**< TODO */
         size_t stringSize; /**< TODO */
-        unsigned char* data; /**< TODO */
-        unsigned char* stringTable; /**< TODO */
+        unsigned char* data; /**< Whole file as read from the archive */
+        unsigned char* records; /**< First record, inside data */
+        unsigned char* stringTable; /**< String table, inside data */
+        uint32 maxId; /**< Highest ID */
+        std::vector<int32> denseIndex; /**< Row of every ID up to maxId, -1 for none; empty when hashed */
+        std::vector<uint32> hashIds; /**< Hash index keys */
+        std::vector<int32> hashRows; /**< Hash index rows, -1 marks an empty slot */
+        uint32 hashMask; /**< Hash index size - 1 */
+};
+
+/**
+ * @brief Typed view over the records of an opened DBCFile
+ *
+ * Entry is one of the schemas of DBCStructure.h. It only has to describe the
+ * leading fields a tool uses, the records may be longer; isValid() checks that
+ * they are at least as long as Entry. Entries are read in place, nothing is
+ * copied.
+ */
+template<class Entry>
+class DBCTable
+{
+    public:
+        /**
+         * @brief
+         *
+         * @param file must be opened and outlive the view
+         */
+        explicit DBCTable(DBCFile const& file)
+            : m_file(file), m_records(file.getRecordData()), m_stride(file.getRecordSize()),
+              m_count(file.getRecordCount())
+        {
+            assert(m_records);
+        }
+
+        /**
+         * @brief Whether the records are large enough to hold Entry
+         *
+         * @return bool
+         */
+        bool isValid() const { return m_stride >= sizeof(Entry); }
+
+        /**
+         * @brief
+         *
+         * @return size_t
+         */
+        size_t size() const { return m_count; }
+
+        /**
+         * @brief Entry at the given row (not ID)
+         *
+         * @param index
+         * @return const Entry &operator
+         */
+        Entry const& operator[](size_t index) const
+        {
+            assert(index < m_count);
+            return *reinterpret_cast<Entry const*>(m_records + index * m_stride);
+        }
+
+        /**
+         * @brief String referenced by a string field of an entry
+         *
+         * @param stringOffset
+         * @return const char
+         */
+        const char* getString(uint32 stringOffset) const { return m_file.getStringAt(stringOffset); }
+
+        /**
+         * @brief Entry with the given ID
+         *
+         * @param id
+         * @return const Entry NULL if there is none
+         */
+        Entry const* findById(uint32 id) const
+        {
+            return reinterpret_cast<Entry const*>(m_file.findById(id));
+        }
+
+    private:
+        DBCFile const& m_file; /**< Owner of the records */
+        const unsigned char* m_records; /**< First record */
+        size_t m_stride; /**< Record size of the file, at least sizeof(Entry) when valid */
+        size_t m_count; /**< Number of records */
 };
 
 #endif
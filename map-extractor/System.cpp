@@ -31,11 +31,14 @@
 #include <vector>
 
 #include "dbcfile.h"
+#include "DBCStructure.h"
 #include <mpq.h>
 
 #include <adt.h>
 #include <wdt.h>
 #include "ExtractorCommon.h"
+#include "ExtractorTelemetry.h"
+#include "ExtractorTrace.h"
 
 #ifndef WIN32
 #include <unistd.h>
@@ -67,8 +70,8 @@ typedef struct
 } map_id;
 
 map_id* map_ids;                    /**< TODO */
-uint16* areas;                      /**< TODO */
-uint16* LiqType;                    /**< TODO */
+DBCFile* AreaTableDbc = NULL;       /**< AreaTable.dbc, looked up by area id */
+DBCFile* LiquidTypeDbc = NULL;      /**< LiquidType.dbc, looked up by liquid type id */
 char output_path[128] = ".";        /**< TODO */
 char input_path[128] = ".";         /**< TODO */
 uint32 maxAreaId = 0;               /**< TODO */
@@ -195,6 +198,8 @@ void Usage(char* prg)
     printf("                         3 = both. Defaults to extracting both.\n");
     printf("   -t, --threads #       worker threads for map conversion. 0 = auto-detect\n");
     printf("                         cores (default), 1 = serial.\n");
+    printTelemetryUsage();
+    printTraceUsage();
     printf("\n");
     printf(" Example:\n");
     printf(" - use input path and do not flatten maps:\n");
@@ -212,6 +217,7 @@ void Usage(char* prg)
 bool HandleArgs(int argc, char** argv)
 {
     char* param = NULL;
+    bool telemetryOk = true;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -277,6 +283,13 @@ bool HandleArgs(int argc, char** argv)
 
             CONF_threads = atoi(param);
         }
+        else if (handleTelemetryArgs(argc, argv, i, telemetryOk) || handleTraceArgs(argc, argv, i, telemetryOk))
+        {
+            if (!telemetryOk)
+            {
+                return false;
+            }
+        }
         else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
         {
             Usage(argv[0]);
@@ -352,12 +365,19 @@ uint32 ReadMapDBC()
         exit(1);
     }
 
-    size_t map_count = dbc.getRecordCount();
+    DBCTable<MapEntry> maps(dbc);
+    if (!maps.isValid())
+    {
+        printf("Fatal error: Unexpected record size in Map.dbc!\n");
+        exit(1);
+    }
+
+    size_t map_count = maps.size();
     map_ids = new map_id[map_count];
     for (uint32 x = 0; x < map_count; ++x)
     {
-        map_ids[x].id = dbc.getRecord(x).getUInt(0);
-        strcpy(map_ids[x].name, dbc.getRecord(x).getString(1));
+        map_ids[x].id = maps[x].ID;
+        strcpy(map_ids[x].name, maps.getString(maps[x].InternalName));
     }
     printf(" Success! %zu maps loaded.\n", map_count);
 
@@ -379,25 +399,23 @@ void ReadAreaTableDBC()
         exit(1);
     }
 
-    DBCFile dbc(dbcFile);
+    AreaTableDbc = new DBCFile(dbcFile);
 
-    if (!dbc.open())
+    if (!AreaTableDbc->open())
     {
         printf("Fatal error: Could not read AreaTable.dbc!\n");
         exit(1);
     }
 
-    size_t area_count = dbc.getRecordCount();
-    size_t maxid = dbc.getMaxId();
-    areas = new uint16[maxid + 1];
-    memset(areas, 0xff, (maxid + 1) * sizeof(uint16));
-
-    for (uint32 x = 0; x < area_count; ++x)
+    DBCTable<AreaTableEntry> areaTable(*AreaTableDbc);
+    if (!areaTable.isValid())
     {
-        areas[dbc.getRecord(x).getUInt(0)] = dbc.getRecord(x).getUInt(3);
+        printf("Fatal error: Unexpected record size in AreaTable.dbc!\n");
+        exit(1);
     }
 
-    maxAreaId = dbc.getMaxId();
+    size_t area_count = areaTable.size();
+    maxAreaId = AreaTableDbc->getMaxId();
 
     printf(" Success! %zu areas loaded.\n", area_count);
 }
@@ -417,23 +435,22 @@ void ReadLiquidTypeTableDBC()
         exit(1);
     }
 
-    DBCFile dbc(dbcFile);
-    if (!dbc.open())
+    LiquidTypeDbc = new DBCFile(dbcFile);
+    if (!LiquidTypeDbc->open())
     {
         printf("Fatal error: Could not read LiquidType.dbc!\n");
         exit(1);
     }
 
-    size_t LiqType_count = dbc.getRecordCount();
-    size_t LiqType_maxid = dbc.getMaxId();
-    LiqType = new uint16[LiqType_maxid + 1];
-    memset(LiqType, 0xff, (LiqType_maxid + 1) * sizeof(uint16));
-
-    for (uint32 x = 0; x < LiqType_count; ++x)
+    DBCTable<LiquidTypeEntry> liquidTypes(*LiquidTypeDbc);
+    if (!liquidTypes.isValid())
     {
-        LiqType[dbc.getRecord(x).getUInt(0)] = dbc.getRecord(x).getUInt(3);
+        printf("Fatal error: Unexpected record size in LiquidType.dbc!\n");
+        exit(1);
     }
 
+    size_t LiqType_count = liquidTypes.size();
+
     printf(" Success! %zu liquid types loaded.\n", LiqType_count);
 }
 
@@ -540,23 +557,68 @@ float selectUInt16StepStore(float maxDiff)
     return 65535 / maxDiff;
 }
 
-// Per-tile working buffers. thread_local so each worker thread owns a private
-// copy: with one thread this is identical to the former plain globals, and it
-// lets ConvertADT run on several tiles concurrently without trampling shared
-// scratch. ConvertADT fully (re)writes/resets these per tile before reading.
-thread_local uint16 area_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];      /**< Temporary grid data store */
+/**
+ * @brief Per-tile working set of ConvertADT
+ *
+ * All scratch data a tile needs lives in one cache-line aligned block so a
+ * worker walks a single contiguous arena instead of eleven unrelated arrays.
+ * Every region starts on its own cache line. Only one packed height
+ * representation is ever used per tile, so uint8 and uint16 share storage.
+ *
+ * Regions ConvertADT always overwrites completely (area flags, heights,
+ * packed heights) are never cleared. The liquid regions are only partially
+ * written, so they are cleared lazily: a tile that touched them marks the
+ * arena dirty and the next tile on that worker resets them before use.
+ */
+struct ADTTileScratch
+{
+    alignas(64) float V9[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];                  /**< Outer height map */
+    alignas(64) float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];                          /**< Inner height map */
+
+    alignas(64) union
+    {
+        struct
+        {
+            uint16 V9[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];
+            uint16 V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+        } u16;                                                                   /**< Heights packed as uint16 */
+        struct
+        {
+            uint8 V9[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];
+            uint8 V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+        } u8;                                                                    /**< Heights packed as uint8 */
+    } packed;
 
-thread_local float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];                         /**< TODO */
-thread_local float V9[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];                 /**< TODO */
-thread_local uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];                 /**< TODO */
-thread_local uint16 uint16_V9[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];         /**< TODO */
-thread_local uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];                  /**< TODO */
-thread_local uint8  uint8_V9[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];          /**< TODO */
+    alignas(64) uint16 area_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];       /**< Area flags per cell */
 
-thread_local uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];    /**< TODO */
-thread_local uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];     /**< TODO */
-thread_local bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];                /**< TODO */
-thread_local float liquid_height[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];      /**< TODO */
+    alignas(64) float liquid_height[ADT_GRID_SIZE + 1][ADT_GRID_SIZE + 1];       /**< Liquid height map */
+    alignas(64) bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];                 /**< Liquid visibility map */
+    alignas(64) uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];     /**< Liquid type entry per cell */
+    alignas(64) uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];      /**< Liquid flags per cell */
+
+    bool liquidDirty;                                                            /**< Liquid regions hold data from a previous tile */
+
+    /**
+     * @brief Clears the regions the previous tile left behind
+     *
+     */
+    void reset()
+    {
+        if (liquidDirty)
+        {
+            memset(liquid_height, 0, sizeof(liquid_height));
+            memset(liquid_show, 0, sizeof(liquid_show));
+            memset(liquid_entry, 0, sizeof(liquid_entry));
+            memset(liquid_flags, 0, sizeof(liquid_flags));
+            liquidDirty = false;
+        }
+    }
+};
+
+// One arena per worker thread. Static storage starts zeroed and clean, and
+// ConvertADT resets whatever it dirtied before the next tile reads it, so a
+// tile's output never depends on which tile the worker processed before.
+thread_local ADTTileScratch sTileScratch;
 
 /**
  * @brief
@@ -570,10 +632,11 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
 {
     ADT_file adt;
 
+    TraceScope stage("adt read");
     {
         // loadFile reads the whole ADT into memory; everything after this is
         // in-memory work, so the MPQ lock is held only for the read itself.
-        std::lock_guard<std::mutex> mpqLock(g_mpqReadMutex);
+        TracedLock mpqLock(g_mpqReadMutex, "mpq lock wait");
         if (!adt.loadFile(filename))
         {
             printf("Error: Failed to load ADT file: %s\n", filename);
@@ -588,31 +651,18 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
         return false;
     }
 
-    // Zero every per-tile scratch buffer up front so a tile's output can never
-    // inherit residual data from a previously processed tile. Cells a tile does
-    // not fully overwrite (e.g. liquid height outside the liquid bounds) are
-    // dead to the server (gated by the liquid flags), but they still land in the
-    // .map file -- leaving them stale made the bytes depend on tile order, which
-    // is non-deterministic once tiles are processed across threads.
-    memset(area_flags, 0, sizeof(area_flags));
-    memset(V8, 0, sizeof(V8));
-    memset(V9, 0, sizeof(V9));
-    memset(uint16_V8, 0, sizeof(uint16_V8));
-    memset(uint16_V9, 0, sizeof(uint16_V9));
-    memset(uint8_V8, 0, sizeof(uint8_V8));
-    memset(uint8_V9, 0, sizeof(uint8_V9));
-    memset(liquid_show, 0, sizeof(liquid_show));
-    memset(liquid_flags, 0, sizeof(liquid_flags));
-    memset(liquid_entry, 0, sizeof(liquid_entry));
-    memset(liquid_height, 0, sizeof(liquid_height));
+    ADTTileScratch& s = sTileScratch;
+    s.reset();
 
     // Prepare map header
+    stage.next("adt area");
     map_fileheader map;
     map.mapMagic = *(uint32 const*)MAP_MAGIC;
     map.versionMagic = *(uint32 const*)MAP_VERSION_MAGIC;
     map.buildMagic = build;
 
     // Get area flags data
+    DBCTable<AreaTableEntry> areaTable(*AreaTableDbc);
     for (int i = 0; i < ADT_CELLS_PER_GRID; i++)
     {
         for (int j = 0; j < ADT_CELLS_PER_GRID; j++)
@@ -621,26 +671,27 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
             uint32 areaid = cell->areaid;
             if (areaid && areaid <= maxAreaId)
             {
-                if (areas[areaid] != 0xffff)
+                AreaTableEntry const* area = areaTable.findById(areaid);
+                if (area && uint16(area->ExploreFlag) != 0xffff)
                 {
-                    area_flags[i][j] = areas[areaid];
+                    s.area_flags[i][j] = uint16(area->ExploreFlag);
                     continue;
                 }
                 printf("File: %s\nCan not find area flag for area %u [%d, %d].\n", filename, areaid, cell->ix, cell->iy);
             }
-            area_flags[i][j] = 0xffff;
+            s.area_flags[i][j] = 0xffff;
         }
     }
     //============================================
     // Try pack area data
     //============================================
     bool fullAreaData = false;
-    uint32 areaflag = area_flags[0][0];
+    uint32 areaflag = s.area_flags[0][0];
     for (int y = 0; y < ADT_CELLS_PER_GRID; y++)
     {
         for (int x = 0; x < ADT_CELLS_PER_GRID; x++)
         {
-            if (area_flags[y][x] != areaflag)
+            if (s.area_flags[y][x] != areaflag)
             {
                 fullAreaData = true;
                 break;
@@ -657,7 +708,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     if (fullAreaData)
     {
         areaHeader.gridArea = 0;
-        map.areaMapSize += sizeof(area_flags);
+        map.areaMapSize += sizeof(s.area_flags);
     }
     else
     {
@@ -668,6 +719,28 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     //
     // Get Height map from grid
     //
+    stage.next("adt height");
+    // When every cell is present the cells tile the whole grid and overwrite
+    // both height maps completely. A missing cell leaves its block at zero, so
+    // only then the maps have to be cleared first.
+    bool allCells = true;
+    for (int i = 0; i < ADT_CELLS_PER_GRID && allCells; i++)
+    {
+        for (int j = 0; j < ADT_CELLS_PER_GRID; j++)
+        {
+            if (!cells->getMCNK(i, j))
+            {
+                allCells = false;
+                break;
+            }
+        }
+    }
+    if (!allCells)
+    {
+        memset(s.V9, 0, sizeof(s.V9));
+        memset(s.V8, 0, sizeof(s.V8));
+    }
+
     for (int i = 0; i < ADT_CELLS_PER_GRID; i++)
     {
         for (int j = 0; j < ADT_CELLS_PER_GRID; j++)
@@ -693,49 +766,44 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
             //    27    28    29    30    31    32    33    34
             // . . . . . . . .
 
-            // Set map height as grid height
-            for (int y = 0; y <= ADT_CELL_SIZE; y++)
-            {
-                int cy = i * ADT_CELL_SIZE + y;
-                for (int x = 0; x <= ADT_CELL_SIZE; x++)
-                {
-                    int cx = j * ADT_CELL_SIZE + x;
-                    V9[cy][cx] = cell->ypos;
-                }
-            }
-            for (int y = 0; y < ADT_CELL_SIZE; y++)
-            {
-                int cy = i * ADT_CELL_SIZE + y;
-                for (int x = 0; x < ADT_CELL_SIZE; x++)
-                {
-                    int cx = j * ADT_CELL_SIZE + x;
-                    V8[cy][cx] = cell->ypos;
-                }
-            }
-            // Get custom height
+            // Map height is the grid height plus the custom height, if any.
+            // Both maps are filled in one sweep per cell row.
+            float ypos = cell->ypos;
             adt_MCVT* v = cell->getMCVT();
-            if (!v)
-            {
-                continue;
-            }
-            // get V9 height map
             for (int y = 0; y <= ADT_CELL_SIZE; y++)
             {
                 int cy = i * ADT_CELL_SIZE + y;
-                for (int x = 0; x <= ADT_CELL_SIZE; x++)
+                float* v9 = &s.V9[cy][j * ADT_CELL_SIZE];
+                float* v8 = y < ADT_CELL_SIZE ? &s.V8[cy][j * ADT_CELL_SIZE] : NULL;
+                if (v)
                 {
-                    int cx = j * ADT_CELL_SIZE + x;
-                    V9[cy][cx] += v->height_map[y * (ADT_CELL_SIZE * 2 + 1) + x];
+                    float const* h9 = &v->height_map[y * (ADT_CELL_SIZE * 2 + 1)];
+                    float const* h8 = h9 + ADT_CELL_SIZE + 1;
+                    for (int x = 0; x <= ADT_CELL_SIZE; x++)
+                    {
+                        v9[x] = ypos + h9[x];
+                    }
+                    if (v8)
+                    {
+                        for (int x = 0; x < ADT_CELL_SIZE; x++)
+                        {
+                            v8[x] = ypos + h8[x];
+                        }
+                    }
                 }
-            }
-            // get V8 height map
-            for (int y = 0; y < ADT_CELL_SIZE; y++)
-            {
-                int cy = i * ADT_CELL_SIZE + y;
-                for (int x = 0; x < ADT_CELL_SIZE; x++)
+                else
                 {
-                    int cx = j * ADT_CELL_SIZE + x;
-                    V8[cy][cx] += v->height_map[y * (ADT_CELL_SIZE * 2 + 1) + ADT_CELL_SIZE + 1 + x];
+                    for (int x = 0; x <= ADT_CELL_SIZE; x++)
+                    {
+                        v9[x] = ypos;
+                    }
+                    if (v8)
+                    {
+                        for (int x = 0; x < ADT_CELL_SIZE; x++)
+                        {
+                            v8[x] = ypos;
+                        }
+                    }
                 }
             }
         }
@@ -743,13 +811,15 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     //============================================
     // Try pack height data
     //============================================
+    // V8 is scanned before V9 as it always was: with equal values of either
+    // sign the first one seen wins, and that decides the stored grid height.
     float maxHeight = -20000;
     float minHeight =  20000;
     for (int y = 0; y < ADT_GRID_SIZE; y++)
     {
         for (int x = 0; x < ADT_GRID_SIZE; x++)
         {
-            float h = V8[y][x];
+            float h = s.V8[y][x];
             if (maxHeight < h)
             {
                 maxHeight = h;
@@ -764,7 +834,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     {
         for (int x = 0; x <= ADT_GRID_SIZE; x++)
         {
-            float h = V9[y][x];
+            float h = s.V9[y][x];
             if (maxHeight < h)
             {
                 maxHeight = h;
@@ -777,30 +847,10 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     }
 
     // Check for allow limit minimum height (not store height in deep ochean - allow save some memory)
-    if (CONF_allow_height_limit && minHeight < CONF_use_minHeight)
+    // The clamp itself is applied below, in the same sweep that packs the heights.
+    bool clampHeight = CONF_allow_height_limit && minHeight < CONF_use_minHeight;
+    if (clampHeight)
     {
-        for (int y = 0; y < ADT_GRID_SIZE; y++)
-        {
-            for (int x = 0; x < ADT_GRID_SIZE; x++)
-            {
-                if (V8[y][x] < CONF_use_minHeight)
-                {
-                    V8[y][x] = CONF_use_minHeight;
-                }
-            }
-        }
-
-        for (int y = 0; y <= ADT_GRID_SIZE; y++)
-        {
-            for (int x = 0; x <= ADT_GRID_SIZE; x++)
-            {
-                if (V9[y][x] < CONF_use_minHeight)
-                {
-                    V9[y][x] = CONF_use_minHeight;
-                }
-            }
-        }
-
         if (minHeight < CONF_use_minHeight)
         {
             minHeight = CONF_use_minHeight;
@@ -851,52 +901,82 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
             }
         }
 
-        // Pack it to int values if need
+        // Clamp and pack in a single sweep over both maps
+        float const limit = CONF_use_minHeight;
         if (heightHeader.flags & MAP_HEIGHT_AS_INT8)
         {
-            for (int y = 0; y < ADT_GRID_SIZE; y++)
-            {
-                for (int x = 0; x < ADT_GRID_SIZE; x++)
-                {
-                    uint8_V8[y][x] = uint8((V8[y][x] - minHeight) * step + 0.5f);
-                }
-            }
-
             for (int y = 0; y <= ADT_GRID_SIZE; y++)
             {
                 for (int x = 0; x <= ADT_GRID_SIZE; x++)
                 {
-                    uint8_V9[y][x] = uint8((V9[y][x] - minHeight) * step + 0.5f);
+                    float h = (clampHeight && s.V9[y][x] < limit) ? limit : s.V9[y][x];
+                    s.packed.u8.V9[y][x] = uint8((h - minHeight) * step + 0.5f);
+                }
+                if (y == ADT_GRID_SIZE)
+                {
+                    break;
                 }
-            }
-            map.heightMapSize += sizeof(uint8_V9) + sizeof(uint8_V8);
-        }
-        else if (heightHeader.flags & MAP_HEIGHT_AS_INT16)
-        {
-            for (int y = 0; y < ADT_GRID_SIZE; y++)
-            {
                 for (int x = 0; x < ADT_GRID_SIZE; x++)
                 {
-                    uint16_V8[y][x] = uint16((V8[y][x] - minHeight) * step + 0.5f);
+                    float h = (clampHeight && s.V8[y][x] < limit) ? limit : s.V8[y][x];
+                    s.packed.u8.V8[y][x] = uint8((h - minHeight) * step + 0.5f);
                 }
             }
-
+            map.heightMapSize += sizeof(s.packed.u8.V9) + sizeof(s.packed.u8.V8);
+        }
+        else if (heightHeader.flags & MAP_HEIGHT_AS_INT16)
+        {
             for (int y = 0; y <= ADT_GRID_SIZE; y++)
             {
                 for (int x = 0; x <= ADT_GRID_SIZE; x++)
                 {
-                    uint16_V9[y][x] = uint16((V9[y][x] - minHeight) * step + 0.5f);
+                    float h = (clampHeight && s.V9[y][x] < limit) ? limit : s.V9[y][x];
+                    s.packed.u16.V9[y][x] = uint16((h - minHeight) * step + 0.5f);
+                }
+                if (y == ADT_GRID_SIZE)
+                {
+                    break;
+                }
+                for (int x = 0; x < ADT_GRID_SIZE; x++)
+                {
+                    float h = (clampHeight && s.V8[y][x] < limit) ? limit : s.V8[y][x];
+                    s.packed.u16.V8[y][x] = uint16((h - minHeight) * step + 0.5f);
                 }
             }
-            map.heightMapSize += sizeof(uint16_V9) + sizeof(uint16_V8);
+            map.heightMapSize += sizeof(s.packed.u16.V9) + sizeof(s.packed.u16.V8);
         }
         else
         {
-            map.heightMapSize += sizeof(V9) + sizeof(V8);
+            if (clampHeight)
+            {
+                for (int y = 0; y <= ADT_GRID_SIZE; y++)
+                {
+                    for (int x = 0; x <= ADT_GRID_SIZE; x++)
+                    {
+                        if (s.V9[y][x] < limit)
+                        {
+                            s.V9[y][x] = limit;
+                        }
+                    }
+                    if (y == ADT_GRID_SIZE)
+                    {
+                        break;
+                    }
+                    for (int x = 0; x < ADT_GRID_SIZE; x++)
+                    {
+                        if (s.V8[y][x] < limit)
+                        {
+                            s.V8[y][x] = limit;
+                        }
+                    }
+                }
+            }
+            map.heightMapSize += sizeof(s.V9) + sizeof(s.V8);
         }
     }
 
     // Get from MCLQ chunk (old)
+    stage.next("adt liquid");
     for (int i = 0; i < ADT_CELLS_PER_GRID; i++)
     {
         for (int j = 0; j < ADT_CELLS_PER_GRID; j++)
@@ -913,6 +993,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
             {
                 continue;
             }
+            s.liquidDirty = true;
 
             for (int y = 0; y < ADT_CELL_SIZE; y++)
             {
@@ -922,10 +1003,10 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                     int cx = j * ADT_CELL_SIZE + x;
                     if (liquid->flags[y][x] != 0x0F)
                     {
-                        liquid_show[cy][cx] = true;
+                        s.liquid_show[cy][cx] = true;
                         if (liquid->flags[y][x] & (1 << 7))
                         {
-                            liquid_flags[i][j] |= MAP_LIQUID_TYPE_DARK_WATER;
+                            s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_DARK_WATER;
                         }
                         ++count;
                     }
@@ -935,21 +1016,21 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
             uint32 c_flag = cell->flags;
             if (c_flag & (1 << 2))
             {
-                liquid_entry[i][j] = 1;
-                liquid_flags[i][j] |= MAP_LIQUID_TYPE_WATER;            // water
+                s.liquid_entry[i][j] = 1;
+                s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_WATER;            // water
             }
             if (c_flag & (1 << 3))
             {
-                liquid_entry[i][j] = 2;
-                liquid_flags[i][j] |= MAP_LIQUID_TYPE_OCEAN;            // ocean
+                s.liquid_entry[i][j] = 2;
+                s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_OCEAN;            // ocean
             }
             if (c_flag & (1 << 4))
             {
-                liquid_entry[i][j] = 3;
-                liquid_flags[i][j] |= MAP_LIQUID_TYPE_MAGMA;            // magma/slime
+                s.liquid_entry[i][j] = 3;
+                s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_MAGMA;            // magma/slime
             }
 
-            if (!count && liquid_flags[i][j])
+            if (!count && s.liquid_flags[i][j])
             {
                 fprintf(stderr, "Wrong liquid type detected in MCLQ chunk");
             }
@@ -960,7 +1041,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                 for (int x = 0; x <= ADT_CELL_SIZE; x++)
                 {
                     int cx = j * ADT_CELL_SIZE + x;
-                    liquid_height[cy][cx] = liquid->liquid[y][x].height;
+                    s.liquid_height[cy][cx] = liquid->liquid[y][x].height;
                 }
             }
         }
@@ -979,6 +1060,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                 {
                     continue;
                 }
+                s.liquidDirty = true;
 
                 int count = 0;
                 uint64 show = h2o->getLiquidShowMap(h);
@@ -990,35 +1072,37 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                         int cx = j * ADT_CELL_SIZE + x + h->xOffset;
                         if (show & 1)
                         {
-                            liquid_show[cy][cx] = true;
+                            s.liquid_show[cy][cx] = true;
                             ++count;
                         }
                         show >>= 1;
                     }
                 }
 
-                liquid_entry[i][j] = h->liquidType;
-                switch (LiqType[h->liquidType])
+                s.liquid_entry[i][j] = h->liquidType;
+                LiquidTypeEntry const* liquid = DBCTable<LiquidTypeEntry>(*LiquidTypeDbc).findById(h->liquidType);
+                uint16 liquidType = liquid ? uint16(liquid->Type) : 0xffff;
+                switch (liquidType)
                 {
-                    case LIQUID_TYPE_WATER: liquid_flags[i][j] |= MAP_LIQUID_TYPE_WATER; break;
-                    case LIQUID_TYPE_OCEAN: liquid_flags[i][j] |= MAP_LIQUID_TYPE_OCEAN; break;
-                    case LIQUID_TYPE_MAGMA: liquid_flags[i][j] |= MAP_LIQUID_TYPE_MAGMA; break;
-                    case LIQUID_TYPE_SLIME: liquid_flags[i][j] |= MAP_LIQUID_TYPE_SLIME; break;
+                    case LIQUID_TYPE_WATER: s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_WATER; break;
+                    case LIQUID_TYPE_OCEAN: s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_OCEAN; break;
+                    case LIQUID_TYPE_MAGMA: s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_MAGMA; break;
+                    case LIQUID_TYPE_SLIME: s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_SLIME; break;
                     default:
                         printf("\nCan not find liquid type %u for map %s\nchunk %d,%d\n", h->liquidType, filename, i, j);
                         break;
                 }
                 // Dark water detect
-                if (LiqType[h->liquidType] == LIQUID_TYPE_OCEAN)
+                if (liquidType == LIQUID_TYPE_OCEAN)
                 {
                     uint8* lm = h2o->getLiquidLightMap(h);
                     if (!lm)
                     {
-                        liquid_flags[i][j] |= MAP_LIQUID_TYPE_DARK_WATER;
+                        s.liquid_flags[i][j] |= MAP_LIQUID_TYPE_DARK_WATER;
                     }
                 }
 
-                if (!count && liquid_flags[i][j])
+                if (!count && s.liquid_flags[i][j])
                 {
                     printf("Wrong liquid type detected in MH2O chunk");
                 }
@@ -1033,11 +1117,11 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                         int cx = j * ADT_CELL_SIZE + x + h->xOffset;
                         if (height)
                         {
-                            liquid_height[cy][cx] = height[pos];
+                            s.liquid_height[cy][cx] = height[pos];
                         }
                         else
                         {
-                            liquid_height[cy][cx] = h->heightLevel1;
+                            s.liquid_height[cy][cx] = h->heightLevel1;
                         }
                         pos++;
                     }
@@ -1048,13 +1132,13 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     //============================================
     // Pack liquid data
     //============================================
-    uint8 type = liquid_flags[0][0];
+    uint8 type = s.liquid_flags[0][0];
     bool fullType = false;
     for (int y = 0; y < ADT_CELLS_PER_GRID; y++)
     {
         for (int x = 0; x < ADT_CELLS_PER_GRID; x++)
         {
-            if (liquid_flags[y][x] != type)
+            if (s.liquid_flags[y][x] != type)
             {
                 fullType = true;
                 y = ADT_CELLS_PER_GRID;
@@ -1082,7 +1166,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
         {
             for (int x = 0; x < ADT_GRID_SIZE; x++)
             {
-                if (liquid_show[y][x])
+                if (s.liquid_show[y][x])
                 {
                     if (minX > x)
                     {
@@ -1100,7 +1184,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                     {
                         maxY = y;
                     }
-                    float h = liquid_height[y][x];
+                    float h = s.liquid_height[y][x];
                     if (maxHeight < h)
                     {
                         maxHeight = h;
@@ -1112,7 +1196,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
                 }
                 else
                 {
-                    liquid_height[y][x] = CONF_use_minHeight;
+                    s.liquid_height[y][x] = CONF_use_minHeight;
                 }
             }
         }
@@ -1149,7 +1233,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
         }
         else
         {
-            map.liquidMapSize += sizeof(liquid_entry) + sizeof(liquid_flags);
+            map.liquidMapSize += sizeof(s.liquid_entry) + sizeof(s.liquid_flags);
         }
 
         if (!(liquidHeader.flags & MAP_LIQUID_NO_HEIGHT))
@@ -1187,6 +1271,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     }
 
     // Ok all data prepared - store it
+    stage.next("adt write");
     FILE* output = fopen(filename2, "wb");
     if (!output)
     {
@@ -1198,7 +1283,7 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     fwrite(&areaHeader, sizeof(areaHeader), 1, output);
     if (!(areaHeader.flags & MAP_AREA_NO_AREA))
     {
-        fwrite(area_flags, sizeof(area_flags), 1, output);
+        fwrite(s.area_flags, sizeof(s.area_flags), 1, output);
     }
 
     // Store height data
@@ -1207,18 +1292,18 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
     {
         if (heightHeader.flags & MAP_HEIGHT_AS_INT16)
         {
-            fwrite(uint16_V9, sizeof(uint16_V9), 1, output);
-            fwrite(uint16_V8, sizeof(uint16_V8), 1, output);
+            fwrite(s.packed.u16.V9, sizeof(s.packed.u16.V9), 1, output);
+            fwrite(s.packed.u16.V8, sizeof(s.packed.u16.V8), 1, output);
         }
         else if (heightHeader.flags & MAP_HEIGHT_AS_INT8)
         {
-            fwrite(uint8_V9, sizeof(uint8_V9), 1, output);
-            fwrite(uint8_V8, sizeof(uint8_V8), 1, output);
+            fwrite(s.packed.u8.V9, sizeof(s.packed.u8.V9), 1, output);
+            fwrite(s.packed.u8.V8, sizeof(s.packed.u8.V8), 1, output);
         }
         else
         {
-            fwrite(V9, sizeof(V9), 1, output);
-            fwrite(V8, sizeof(V8), 1, output);
+            fwrite(s.V9, sizeof(s.V9), 1, output);
+            fwrite(s.V8, sizeof(s.V8), 1, output);
         }
     }
 
@@ -1228,14 +1313,14 @@ bool ConvertADT(char* filename, char* filename2, uint32 build)
         fwrite(&liquidHeader, sizeof(liquidHeader), 1, output);
         if (!(liquidHeader.flags & MAP_LIQUID_NO_TYPE))
         {
-            fwrite(liquid_entry, sizeof(liquid_entry), 1, output);
-            fwrite(liquid_flags, sizeof(liquid_flags), 1, output);
+            fwrite(s.liquid_entry, sizeof(s.liquid_entry), 1, output);
+            fwrite(s.liquid_flags, sizeof(s.liquid_flags), 1, output);
         }
         if (!(liquidHeader.flags & MAP_LIQUID_NO_HEIGHT))
         {
             for (int y = 0; y < liquidHeader.height; y++)
             {
-                fwrite(&liquid_height[y + liquidHeader.offsetY][liquidHeader.offsetX], sizeof(float), liquidHeader.width, output);
+                fwrite(&s.liquid_height[y + liquidHeader.offsetY][liquidHeader.offsetX], sizeof(float), liquidHeader.width, output);
             }
         }
     }
@@ -1256,6 +1341,7 @@ void ExtractMapsFromMpq(uint32 build)
 {
     char mpq_map_name[1024];
 
+    TelemetryPhase phase("maps");
     printf("\n Extracting maps...\n");
 
     uint32 map_count = ReadMapDBC();
@@ -1323,6 +1409,7 @@ void ExtractMapsFromMpq(uint32 build)
             }
         }
         adt_count = static_cast<uint32>(tileQueue.size());
+        addTelemetryWork(adt_count);
 
         uint32 nThreads = CONF_threads ? CONF_threads : std::thread::hardware_concurrency();
         if (nThreads < 1)
@@ -1337,7 +1424,7 @@ void ExtractMapsFromMpq(uint32 build)
             char tile_out[1024];
             while (true)
             {
-                uint32 tileX, tileY;
+                uint32 tileX, tileY, queueDepth;
                 {
                     std::lock_guard<std::mutex> lock(queueMutex);
                     if (tileQueue.empty())
@@ -1347,7 +1434,9 @@ void ExtractMapsFromMpq(uint32 build)
                     tileX = tileQueue.front().first;
                     tileY = tileQueue.front().second;
                     tileQueue.pop();
+                    queueDepth = static_cast<uint32>(tileQueue.size());
                 }
+                TelemetryTile tile(map_ids[z].id, tileX, tileY, queueDepth);
                 sprintf(tile_mpq, "World\\Maps\\%s\\%s_%u_%u.adt", map_ids[z].name, map_ids[z].name, tileX, tileY);
                 sprintf(tile_out, "%s/maps/%04u%02u%02u.map", output_path, map_ids[z].id, tileY, tileX);
                 if (ConvertADT(tile_mpq, tile_out, build))
@@ -1357,6 +1446,7 @@ void ExtractMapsFromMpq(uint32 build)
                 else
                 {
                     ++failed_count;
+                    tile.fail();
                 }
             }
         };
@@ -1393,7 +1483,8 @@ void ExtractMapsFromMpq(uint32 build)
     printf("\n\nMap extraction complete!\n");
     printf("Successfully converted: %u tiles\n", success_count.load());
     printf("Failed to convert: %u tiles\n", failed_count.load());
-    delete [] areas;
+    delete AreaTableDbc;
+    delete LiquidTypeDbc;
     delete [] map_ids;
 }
 
@@ -1403,6 +1494,7 @@ void ExtractMapsFromMpq(uint32 build)
  */
 void ExtractDBCFiles(int locale, bool basicLocale)
 {
+    TelemetryPhase phase("dbc");
     printf(" ___________________________________    \n");
     printf("\n Extracting client database files...\n");
 
@@ -1726,6 +1818,9 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    initTelemetry("map-extractor");
+    initTrace();
+
     printf("Selected Options: \n");
     printf("Input Path: %s\n", input_path);
     printf("Output Path: %s\n", output_path);
@@ -1841,5 +1936,8 @@ int main(int argc, char** argv)
             }
             break;
     }
+
+    shutdownTelemetry();
+    writeTrace();
     return 0;
 }
@@ -0,0 +1,139 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MANGOS_H_BINARY_WRITER
+#define MANGOS_H_BINARY_WRITER
+
+#include <cstdio>
+#include <vector>
+
+/**
+ * Buffered writer for the extractors' binary output.
+ *
+ * Values are appended to a caller owned buffer. Without a file the buffer is
+ * the output, for data that is assembled in memory and written later. With a
+ * file the buffer is written out in large blocks once it reaches the flush
+ * size and by flush(), then cleared, so one buffer kept per thread serves
+ * every file that thread writes without reallocating. This replaces runs of
+ * 4 to 12 byte fwrite() calls, each of which takes the stdio lock.
+ */
+class BinaryWriter
+{
+    public:
+        static const size_t FLUSH_SIZE = 256 * 1024; ///< buffered bytes that trigger a write to the file
+
+        /**
+         * @brief
+         *
+         * @param buffer receives the output; appended to, never cleared, when file is NULL
+         * @param file written to by flush(), which must then be called before the file is closed
+         */
+        explicit BinaryWriter(std::vector<char>& buffer, FILE* file = NULL) : m_buffer(buffer), m_file(file), m_failed(false)
+        {
+            if (m_file)
+            {
+                m_buffer.clear();
+            }
+        }
+
+        /**
+         * @brief Appends the bytes of one value
+         *
+         * @param value
+         */
+        template<class T>
+        void put(T const& value)
+        {
+            putBytes(&value, sizeof(T));
+        }
+
+        /**
+         * @brief Appends count consecutive values
+         *
+         * @param values
+         * @param count
+         */
+        template<class T>
+        void putSpan(T const* values, size_t count)
+        {
+            putBytes(values, sizeof(T) * count);
+        }
+
+        /**
+         * @brief Appends a four character chunk tag such as "VERT", without its NUL
+         *
+         * @param tag
+         */
+        void putTag(char const (&tag)[5])
+        {
+            putBytes(tag, 4);
+        }
+
+        /**
+         * @brief
+         *
+         * @param data
+         * @param size
+         */
+        void putBytes(void const* data, size_t size)
+        {
+            if (m_file && m_buffer.size() + size > FLUSH_SIZE)
+            {
+                flush();
+                if (size >= FLUSH_SIZE)
+                {
+                    // Large blocks go straight to the file
+                    m_failed |= fwrite(data, 1, size, m_file) != size;
+                    return;
+                }
+            }
+            char const* bytes = static_cast<char const*>(data);
+            m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        }
+
+        /**
+         * @brief Writes the buffered bytes to the file, if there is one
+         *
+         * @return bool false if any write to the file has failed
+         */
+        bool flush()
+        {
+            if (m_file && !m_buffer.empty())
+            {
+                m_failed |= fwrite(&m_buffer[0], 1, m_buffer.size(), m_file) != m_buffer.size();
+                m_buffer.clear();
+            }
+            return !m_failed;
+        }
+
+    private:
+        BinaryWriter(BinaryWriter const&);
+        BinaryWriter& operator=(BinaryWriter const&);
+
+        std::vector<char>& m_buffer;    /**< TODO */
+        FILE* m_file;                   /**< TODO */
+        bool m_failed;                  /**< TODO */
+};
+
+#endif
@@ -0,0 +1,438 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include "ExtractorMemory.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#define MEMORY_BLOCK_SIZE(ptr) _msize(ptr)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <sys/resource.h>
+#define MEMORY_BLOCK_SIZE(ptr) malloc_size(ptr)
+#elif defined(__FreeBSD__)
+#include <malloc_np.h>
+#include <sys/resource.h>
+#define MEMORY_BLOCK_SIZE(ptr) malloc_usable_size(ptr)
+#else
+#include <malloc.h>
+#include <unistd.h>
+#define MEMORY_BLOCK_SIZE(ptr) malloc_usable_size(ptr)
+#endif
+
+#define MEMORY_SLOTS 512                        ///< Threads with a slot of their own at once, the rest share the last one
+#define MEMORY_SHARED_SLOT (MEMORY_SLOTS - 1)   ///< Slot of threads that found no free one
+#define MEMORY_NO_SLOT (-1)                     ///< Thread without a slot yet
+
+namespace
+{
+    /// Counters of one slot. A slot is owned by one thread at a time, but the
+    /// shared slot has many writers, hence the atomics.
+    struct alignas(64) MemorySlot
+    {
+        std::atomic<bool> owned;
+        std::atomic<uint64> allocs;
+        std::atomic<uint64> bytes;
+        std::atomic<int64> live;
+        std::atomic<int64> peak;
+    };
+
+    // Zero-initialized before any constructor runs, so allocations made during
+    // static initialization can already use them.
+    MemorySlot sSlots[MEMORY_SLOTS];
+    std::atomic<bool> sAccounting;
+
+    // Plain int, so the allocation hook never touches an object that is being
+    // destroyed at thread exit
+    thread_local int32 t_slot = MEMORY_NO_SLOT;
+
+    /// Gives the slot of a thread back when the thread exits, so the tools
+    /// that start new threads for every map do not run out of slots
+    struct MemorySlotOwner
+    {
+        MemorySlotOwner() : slot(MEMORY_NO_SLOT) {}
+        ~MemorySlotOwner()
+        {
+            if (slot != MEMORY_NO_SLOT)
+            {
+                // Anything the exiting thread still allocates goes to the shared slot
+                t_slot = MEMORY_SHARED_SLOT;
+                sSlots[slot].owned.store(false, std::memory_order_release);
+            }
+        }
+
+        int32 slot;
+    };
+
+    int32 acquireSlot()
+    {
+        for (int32 i = 0; i < MEMORY_SHARED_SLOT; ++i)
+        {
+            bool owned = false;
+            if (!sSlots[i].owned.load(std::memory_order_relaxed) &&
+                sSlots[i].owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+            {
+                static thread_local MemorySlotOwner owner;
+                owner.slot = i;
+                return i;
+            }
+        }
+        return MEMORY_SHARED_SLOT;
+    }
+
+    MemorySlot& threadSlot()
+    {
+        if (t_slot == MEMORY_NO_SLOT)
+        {
+            t_slot = acquireSlot();
+        }
+        return sSlots[t_slot];
+    }
+
+    void countAlloc(void* ptr)
+    {
+        if (!ptr || !sAccounting.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        int64 size = int64(MEMORY_BLOCK_SIZE(ptr));
+        MemorySlot& slot = threadSlot();
+        slot.allocs.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(uint64(size), std::memory_order_relaxed);
+        int64 live = slot.live.fetch_add(size, std::memory_order_relaxed) + size;
+        int64 peak = slot.peak.load(std::memory_order_relaxed);
+        while (live > peak && !slot.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void countFree(void* ptr)
+    {
+        if (!ptr || !sAccounting.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        threadSlot().live.fetch_sub(int64(MEMORY_BLOCK_SIZE(ptr)), std::memory_order_relaxed);
+    }
+
+    /// Over-aligned block: malloc'ed with room to align it, the malloc'ed
+    /// address is kept right in front of the block for alignedFree()
+    void* alignedMalloc(size_t size, size_t align)
+    {
+        size_t extra = align - 1 + sizeof(void*);
+        if (size > size_t(-1) - extra)
+        {
+            return NULL;
+        }
+
+        void* base = accountedMalloc(size + extra);
+        if (!base)
+        {
+            return NULL;
+        }
+
+        uintptr_t block = (uintptr_t(base) + sizeof(void*) + align - 1) & ~uintptr_t(align - 1);
+        reinterpret_cast<void**>(block)[-1] = base;
+        return reinterpret_cast<void*>(block);
+    }
+
+    void alignedFree(void* ptr)
+    {
+        if (ptr)
+        {
+            accountedFree(reinterpret_cast<void**>(ptr)[-1]);
+        }
+    }
+
+    /// align 0 for the default alignment of malloc
+    void* allocOrThrow(size_t size, size_t align)
+    {
+        for (;;)
+        {
+            void* ptr = align ? alignedMalloc(size ? size : 1, align) : accountedMalloc(size ? size : 1);
+            if (ptr)
+            {
+                return ptr;
+            }
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* allocOrNull(size_t size, size_t align)
+    {
+        try
+        {
+            return allocOrThrow(size, align);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+}
+
+void enableMemoryAccounting()
+{
+    sAccounting.store(true, std::memory_order_relaxed);
+}
+
+bool isMemoryAccountingEnabled()
+{
+    return sAccounting.load(std::memory_order_relaxed);
+}
+
+MemoryCounters getThreadMemory()
+{
+    MemorySlot& slot = threadSlot();
+
+    MemoryCounters counters;
+    counters.allocs = slot.allocs.load(std::memory_order_relaxed);
+    counters.bytes = slot.bytes.load(std::memory_order_relaxed);
+    counters.live = slot.live.load(std::memory_order_relaxed);
+    counters.peak = slot.peak.load(std::memory_order_relaxed);
+    return counters;
+}
+
+void resetThreadMemoryPeak()
+{
+    MemorySlot& slot = threadSlot();
+    slot.peak.store(slot.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+MemoryCounters getProcessMemory()
+{
+    MemoryCounters counters;
+    for (uint32 i = 0; i < MEMORY_SLOTS; ++i)
+    {
+        counters.allocs += sSlots[i].allocs.load(std::memory_order_relaxed);
+        counters.bytes += sSlots[i].bytes.load(std::memory_order_relaxed);
+        counters.live += sSlots[i].live.load(std::memory_order_relaxed);
+    }
+    counters.peak = counters.live;
+    return counters;
+}
+
+uint64 getResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return uint64(pmc.WorkingSetSize);
+    }
+    return 0;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    return 0;
+#else
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm)
+    {
+        return 0;
+    }
+
+    unsigned long long size = 0, resident = 0;
+    int fields = fscanf(statm, "%llu %llu", &size, &resident);
+    fclose(statm);
+    return fields == 2 ? uint64(resident) * uint64(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+uint64 getPeakResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return uint64(pmc.PeakWorkingSetSize);
+    }
+    return 0;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return uint64(usage.ru_maxrss);                     // bytes
+#else
+    return uint64(usage.ru_maxrss) * 1024;              // kilobytes
+#endif
+#else
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status)
+    {
+        return 0;
+    }
+
+    char line[128];
+    unsigned long long peak = 0;
+    while (fgets(line, sizeof(line), status))
+    {
+        if (sscanf(line, "VmHWM: %llu kB", &peak) == 1)
+        {
+            break;
+        }
+    }
+    fclose(status);
+    return uint64(peak) * 1024;
+#endif
+}
+
+void* accountedMalloc(size_t size)
+{
+    void* ptr = malloc(size);
+    countAlloc(ptr);
+    return ptr;
+}
+
+void accountedFree(void* ptr)
+{
+    countFree(ptr);
+    free(ptr);
+}
+
+// Replaced global allocation functions. Every tool links this file, so all of
+// their C++ allocations are counted once accounting is enabled. Plain blocks
+// are malloc blocks as they are; only the over-aligned forms keep the
+// malloc'ed address in front of the block, sizeof(void*) plus the padding.
+
+void* operator new(size_t size)
+{
+    return allocOrThrow(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+    return allocOrThrow(size, 0);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    return allocOrNull(size, 0);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    return allocOrNull(size, 0);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    accountedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    accountedFree(ptr);
+}
+
+void operator delete(void* ptr, std::nothrow_t const&) noexcept
+{
+    accountedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept
+{
+    accountedFree(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, size_t) noexcept
+{
+    accountedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    accountedFree(ptr);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t align)
+{
+    return allocOrThrow(size, size_t(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align)
+{
+    return allocOrThrow(size, size_t(align));
+}
+
+void* operator new(size_t size, std::align_val_t align, std::nothrow_t const&) noexcept
+{
+    return allocOrNull(size, size_t(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align, std::nothrow_t const&) noexcept
+{
+    return allocOrNull(size, size_t(align));
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, std::nothrow_t const&) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, std::nothrow_t const&) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+#endif
@@ -0,0 +1,120 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MANGOS_H_EXTRACTOR_MEMORY
+#define MANGOS_H_EXTRACTOR_MEMORY
+
+#include <stddef.h>
+#include "loadlib.h"
+
+/**
+ * Allocation accounting and RSS sampling shared by the extractors.
+ *
+ * The global operator new/delete of every tool go through malloc/free here.
+ * Once enableMemoryAccounting() has been called each allocation also bumps
+ * the counters of the calling thread: allocation count, bytes allocated,
+ * bytes currently held and the high-water mark of the latter. Counters live
+ * in slots that a thread owns until it exits, after which the next new thread
+ * reuses them, so the hook takes no lock. Blocks stay plain malloc blocks, so
+ * a free is charged to the thread that frees the block. The telemetry
+ * snapshots the slots per phase and per tile.
+ */
+
+/**
+ * @brief Allocation counters of one thread, or summed over all threads
+ *
+ */
+struct MemoryCounters
+{
+    MemoryCounters() : allocs(0), bytes(0), live(0), peak(0) {}
+
+    uint64 allocs;      /**< Number of allocations */
+    uint64 bytes;       /**< Bytes allocated, freed ones included */
+    int64 live;         /**< Bytes allocated minus bytes freed by the threads of this slot */
+    int64 peak;         /**< Highest live value since resetThreadMemoryPeak() */
+};
+
+/**
+ * @brief Starts counting allocations; blocks allocated before are only counted when freed
+ *
+ */
+void enableMemoryAccounting();
+
+/**
+ * @brief
+ *
+ * @return bool true once enableMemoryAccounting() was called
+ */
+bool isMemoryAccountingEnabled();
+
+/**
+ * @brief Counters of the calling thread
+ *
+ * @return MemoryCounters
+ */
+MemoryCounters getThreadMemory();
+
+/**
+ * @brief Restarts the high-water mark of the calling thread at its current live bytes
+ *
+ */
+void resetThreadMemoryPeak();
+
+/**
+ * @brief Counters summed over every thread seen so far; peak is not meaningful here
+ *
+ * @return MemoryCounters
+ */
+MemoryCounters getProcessMemory();
+
+/**
+ * @brief Current resident set size of the process
+ *
+ * @return uint64 bytes, 0 if the platform can not tell
+ */
+uint64 getResidentBytes();
+
+/**
+ * @brief Highest resident set size of the process so far
+ *
+ * @return uint64 bytes, 0 if the platform can not tell
+ */
+uint64 getPeakResidentBytes();
+
+/**
+ * @brief malloc that is counted like operator new, for third party allocator hooks
+ *
+ * @param size
+ * @return void
+ */
+void* accountedMalloc(size_t size);
+
+/**
+ * @brief free for blocks returned by accountedMalloc()
+ *
+ * @param ptr
+ */
+void accountedFree(void* ptr);
+
+#endif
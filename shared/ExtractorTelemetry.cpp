@@ -0,0 +1,665 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ExtractorTelemetry.h"
+
+typedef std::chrono::steady_clock TelemetryClock;
+
+static uint32 CONF_telemetryInterval = 10;      ///< Seconds between progress lines, 0 = no progress lines
+static uint32 CONF_telemetrySlowest  = 10;      ///< Number of slowest tiles kept for the summary
+static char const* CONF_telemetryJson = NULL;   ///< JSON lines output file, NULL = none
+static bool CONF_telemetryMemory = false;       ///< Report allocations and RSS per phase and tile
+
+namespace
+{
+    /// One finished tile, as kept for the slowest-N list
+    struct TileSample
+    {
+        double seconds;
+        uint32 mapId;
+        uint32 tileX;
+        uint32 tileY;
+        uint32 worker;
+        uint64 allocs;          ///< allocations made by the worker during the tile
+        uint64 heapPeak;        ///< peak heap of the worker above its level at tile start
+    };
+
+    /// One finished phase
+    struct PhaseSample
+    {
+        char const* name;
+        double seconds;
+        uint64 tiles;
+        uint64 allocs;
+        uint64 bytes;
+        uint64 rssPeak;         ///< highest RSS sampled during the phase
+        uint64 rssEnd;
+    };
+
+    /// Per worker totals, to spot idle or overloaded threads
+    struct WorkerSample
+    {
+        WorkerSample() : tiles(0), busy(0.0), heapPeak(0), heapSampled(false) {}
+        uint64 tiles;
+        double busy;
+        uint64 heapPeak;
+        bool heapSampled;       ///< some tile of the worker measured its heap
+    };
+
+    struct TelemetryState
+    {
+        TelemetryState() : tool("extractor"), json(NULL), phase(NULL), queued(0), done(0), failed(0),
+            doneAtLastReport(0), lastQueueDepth(0), rssPeak(0), nextWorkerId(0), stopTicker(false) {}
+
+        std::mutex lock;                        ///< guards everything below
+        char const* tool;
+        FILE* json;
+        char const* phase;                      ///< innermost running phase, NULL outside phases
+        TelemetryClock::time_point start;
+        TelemetryClock::time_point lastReport;
+        uint64 queued;
+        uint64 done;
+        uint64 failed;
+        uint64 doneAtLastReport;
+        uint32 lastQueueDepth;
+        uint64 rssPeak;                         ///< highest RSS sampled since the current phase began
+        std::vector<PhaseSample> phases;
+        std::vector<TileSample> slowest;        ///< min-heap on seconds
+        std::vector<TileSample> largest;        ///< min-heap on heapPeak
+        std::vector<WorkerSample> workers;
+        std::vector<TelemetryCounter const*> counters;  ///< in order of construction
+        uint32 nextWorkerId;
+        std::vector<uint32> freeWorkerIds;      ///< ids of worker threads that have exited
+        std::thread ticker;                     ///< prints the progress lines
+        std::condition_variable tick;           ///< wakes the ticker to stop
+        bool stopTicker;
+    };
+
+    /// Never destroyed, so the ticker thread can still use it if a tool ends
+    /// through exit() without shutdownTelemetry()
+    TelemetryState& state()
+    {
+        static TelemetryState* s = new TelemetryState();
+        return *s;
+    }
+
+    /// TelemetryTile scopes open on this thread
+    thread_local uint32 t_openTiles = 0;
+
+    /// Gives the worker id of a thread back when the thread exits. The tools
+    /// start new threads for every map or pass, and without this the worker
+    /// table would get a row per thread ever started instead of per worker.
+    struct TelemetryWorkerId
+    {
+        TelemetryWorkerId() : id(uint32(-1)) {}
+        ~TelemetryWorkerId()
+        {
+            if (id != uint32(-1))
+            {
+                TelemetryState& s = state();
+                std::lock_guard<std::mutex> guard(s.lock);
+                s.freeWorkerIds.push_back(id);
+            }
+        }
+
+        uint32 id;
+    };
+
+    bool slowerThan(TileSample const& a, TileSample const& b)
+    {
+        return a.seconds > b.seconds;
+    }
+
+    bool largerThan(TileSample const& a, TileSample const& b)
+    {
+        return a.heapPeak > b.heapPeak;
+    }
+
+    double megabytes(uint64 bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    double nanosecondsToSeconds(uint64 nanoseconds)
+    {
+        return nanoseconds / 1e9;
+    }
+
+    /// Keeps the CONF_telemetrySlowest greatest samples in a min-heap ordered by greater
+    void keepTop(std::vector<TileSample>& heap, TileSample const& sample, bool (*greater)(TileSample const&, TileSample const&))
+    {
+        if (heap.size() < CONF_telemetrySlowest)
+        {
+            heap.push_back(sample);
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+        else if (greater(sample, heap.front()))
+        {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            heap.back() = sample;
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+    }
+
+    double secondsSince(TelemetryClock::time_point from, TelemetryClock::time_point to)
+    {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    /// Writes the fields every JSON event starts with. Caller holds the lock.
+    void beginJsonEvent(TelemetryState& s, char const* event, TelemetryClock::time_point now)
+    {
+        fprintf(s.json, "{\"tool\":\"%s\",\"event\":\"%s\",\"time\":%.6f", s.tool, event, secondsSince(s.start, now));
+    }
+
+    /// Prints the periodic progress line. Caller holds the lock.
+    void reportProgress(TelemetryState& s, TelemetryClock::time_point now)
+    {
+        double elapsed = secondsSince(s.start, now);
+        double window = secondsSince(s.lastReport, now);
+        double rate = elapsed > 0.0 ? s.done / elapsed : 0.0;
+        double recentRate = window > 0.0 ? (s.done - s.doneAtLastReport) / window : 0.0;
+
+        char const* phase = s.phase ? s.phase : "-";
+        if (s.queued)
+        {
+            printf(" Progress [%s]: %llu/%llu tiles (%.1f%%), %.1f tiles/s (recent %.1f), queue %u, %.0f s elapsed\n",
+                phase, (unsigned long long)s.done, (unsigned long long)s.queued, 100.0 * s.done / s.queued,
+                rate, recentRate, s.lastQueueDepth, elapsed);
+        }
+        else
+        {
+            printf(" Progress [%s]: %llu tiles, %.1f tiles/s (recent %.1f), queue %u, %.0f s elapsed\n",
+                phase, (unsigned long long)s.done, rate, recentRate, s.lastQueueDepth, elapsed);
+        }
+
+        if (s.json)
+        {
+            beginJsonEvent(s, "progress", now);
+            fprintf(s.json, ",\"phase\":\"%s\",\"done\":%llu,\"queued\":%llu,\"failed\":%llu,\"tilesPerSec\":%.3f,\"recentTilesPerSec\":%.3f,\"queue\":%u}\n",
+                phase, (unsigned long long)s.done, (unsigned long long)s.queued, (unsigned long long)s.failed,
+                rate, recentRate, s.lastQueueDepth);
+            fflush(s.json);
+        }
+
+        s.lastReport = now;
+        s.doneAtLastReport = s.done;
+    }
+
+    /// Body of the ticker thread: prints the progress line every interval,
+    /// also during phases that finish no tiles
+    void runTicker()
+    {
+        TelemetryState& s = state();
+        std::unique_lock<std::mutex> guard(s.lock);
+        while (!s.stopTicker)
+        {
+            TelemetryClock::time_point due = s.lastReport + std::chrono::seconds(CONF_telemetryInterval);
+            if (!s.tick.wait_until(guard, due, [&s] { return s.stopTicker; }))
+            {
+                reportProgress(s, TelemetryClock::now());
+            }
+        }
+    }
+}
+
+bool handleTelemetryArgs(int argc, char** argv, int& i, bool& ok)
+{
+    if (strcmp(argv[i], "--telemetry-interval") == 0)
+    {
+        if (i + 1 >= argc)
+        {
+            ok = false;
+            return true;
+        }
+        CONF_telemetryInterval = atoi(argv[++i]);
+        return true;
+    }
+    if (strcmp(argv[i], "--telemetry-slowest") == 0)
+    {
+        if (i + 1 >= argc)
+        {
+            ok = false;
+            return true;
+        }
+        CONF_telemetrySlowest = atoi(argv[++i]);
+        return true;
+    }
+    if (strcmp(argv[i], "--telemetry-json") == 0)
+    {
+        if (i + 1 >= argc)
+        {
+            ok = false;
+            return true;
+        }
+        CONF_telemetryJson = argv[++i];
+        return true;
+    }
+    if (strcmp(argv[i], "--telemetry-memory") == 0)
+    {
+        CONF_telemetryMemory = true;
+        enableMemoryAccounting();
+        return true;
+    }
+    return false;
+}
+
+void printTelemetryUsage()
+{
+    printf("   --telemetry-interval #    seconds between progress lines, 0 = off (default 10)\n");
+    printf("   --telemetry-slowest #     number of slowest tiles in the summary (default 10)\n");
+    printf("   --telemetry-json <file>   also write telemetry events as JSON lines to file\n");
+    printf("   --telemetry-memory        count allocations and report peak memory per phase\n");
+    printf("                             and tile\n");
+}
+
+void initTelemetry(char const* tool)
+{
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    s.tool = tool;
+    s.start = s.lastReport = TelemetryClock::now();
+
+    if (CONF_telemetryJson && !s.json)
+    {
+        s.json = fopen(CONF_telemetryJson, "w");
+        if (!s.json)
+        {
+            printf("Can not create the telemetry file '%s'\n", CONF_telemetryJson);
+            return;
+        }
+        beginJsonEvent(s, "start", s.start);
+        fprintf(s.json, "}\n");
+    }
+
+    if (CONF_telemetryInterval && !s.ticker.joinable())
+    {
+        s.ticker = std::thread(runTicker);
+    }
+}
+
+void shutdownTelemetry()
+{
+    TelemetryState& s = state();
+    if (s.ticker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(s.lock);
+            s.stopTicker = true;
+        }
+        s.tick.notify_all();
+        s.ticker.join();
+    }
+
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    TelemetryClock::time_point now = TelemetryClock::now();
+    double elapsed = secondsSince(s.start, now);
+    double rate = elapsed > 0.0 ? s.done / elapsed : 0.0;
+
+    std::vector<TileSample> slowest = s.slowest;
+    std::sort(slowest.begin(), slowest.end(), slowerThan);
+    std::vector<TileSample> largest = s.largest;
+    std::sort(largest.begin(), largest.end(), largerThan);
+
+    printf("\n Telemetry summary (%s)\n", s.tool);
+    for (size_t i = 0; i < s.phases.size(); ++i)
+    {
+        PhaseSample const& phase = s.phases[i];
+        if (phase.tiles)
+        {
+            printf("   Phase %-16s %10.2f s  %8llu tiles  %8.1f tiles/s\n", phase.name, phase.seconds,
+                (unsigned long long)phase.tiles, phase.seconds > 0.0 ? phase.tiles / phase.seconds : 0.0);
+        }
+        else
+        {
+            printf("   Phase %-16s %10.2f s\n", phase.name, phase.seconds);
+        }
+        if (CONF_telemetryMemory)
+        {
+            printf("         %-16s %10llu allocs  %10.1f MB allocated  %8.1f MB peak RSS\n", "",
+                (unsigned long long)phase.allocs, megabytes(phase.bytes), megabytes(phase.rssPeak));
+        }
+    }
+    printf("   Tiles: %llu done, %llu failed, %.1f tiles/s over %.2f s\n",
+        (unsigned long long)s.done, (unsigned long long)s.failed, rate, elapsed);
+    if (CONF_telemetryMemory)
+    {
+        printf("   Peak RSS: %.1f MB\n", megabytes(getPeakResidentBytes()));
+    }
+    for (size_t i = 0; i < s.workers.size(); ++i)
+    {
+        if (s.workers[i].heapSampled)
+        {
+            printf("   Worker %-3u %8llu tiles  %10.2f s busy  %8.1f MB peak heap per tile\n", (uint32)i,
+                (unsigned long long)s.workers[i].tiles, s.workers[i].busy, megabytes(s.workers[i].heapPeak));
+        }
+        else
+        {
+            printf("   Worker %-3u %8llu tiles  %10.2f s busy\n", (uint32)i,
+                (unsigned long long)s.workers[i].tiles, s.workers[i].busy);
+        }
+    }
+    if (!s.counters.empty())
+    {
+        printf("   Counters:\n");
+        for (size_t i = 0; i < s.counters.size(); ++i)
+        {
+            TelemetryCounter const& counter = *s.counters[i];
+            switch (counter.getUnit())
+            {
+                case TELEMETRY_BYTES:
+                    printf("     %-28s %12.1f MB\n", counter.getName(), megabytes(counter.get()));
+                    break;
+                case TELEMETRY_TIME:
+                    printf("     %-28s %12.2f s\n", counter.getName(), nanosecondsToSeconds(counter.get()));
+                    break;
+                default:
+                    printf("     %-28s %12llu\n", counter.getName(), (unsigned long long)counter.get());
+                    break;
+            }
+        }
+    }
+    if (!slowest.empty())
+    {
+        printf("   Slowest tiles:\n");
+        for (size_t i = 0; i < slowest.size(); ++i)
+        {
+            printf("     map %04u [%02u,%02u]  %8.3f s  worker %u\n", slowest[i].mapId,
+                slowest[i].tileX, slowest[i].tileY, slowest[i].seconds, slowest[i].worker);
+        }
+    }
+    if (!largest.empty())
+    {
+        printf("   Largest tiles (peak heap):\n");
+        for (size_t i = 0; i < largest.size(); ++i)
+        {
+            printf("     map %04u [%02u,%02u]  %8.1f MB  %10llu allocs  worker %u\n", largest[i].mapId,
+                largest[i].tileX, largest[i].tileY, megabytes(largest[i].heapPeak),
+                (unsigned long long)largest[i].allocs, largest[i].worker);
+        }
+    }
+
+    if (s.json)
+    {
+        beginJsonEvent(s, "summary", now);
+        fprintf(s.json, ",\"done\":%llu,\"failed\":%llu,\"seconds\":%.6f,\"tilesPerSec\":%.3f,\"slowest\":[",
+            (unsigned long long)s.done, (unsigned long long)s.failed, elapsed, rate);
+        for (size_t i = 0; i < slowest.size(); ++i)
+        {
+            fprintf(s.json, "%s{\"map\":%u,\"x\":%u,\"y\":%u,\"worker\":%u,\"seconds\":%.6f}", i ? "," : "",
+                slowest[i].mapId, slowest[i].tileX, slowest[i].tileY, slowest[i].worker, slowest[i].seconds);
+        }
+        fprintf(s.json, "]");
+        if (!s.counters.empty())
+        {
+            fprintf(s.json, ",\"counters\":{");
+            for (size_t i = 0; i < s.counters.size(); ++i)
+            {
+                TelemetryCounter const& counter = *s.counters[i];
+                if (counter.getUnit() == TELEMETRY_TIME)
+                {
+                    fprintf(s.json, "%s\"%s\":%.6f", i ? "," : "", counter.getName(), nanosecondsToSeconds(counter.get()));
+                }
+                else
+                {
+                    fprintf(s.json, "%s\"%s\":%llu", i ? "," : "", counter.getName(), (unsigned long long)counter.get());
+                }
+            }
+            fprintf(s.json, "}");
+        }
+        if (CONF_telemetryMemory)
+        {
+            fprintf(s.json, ",\"peakRss\":%llu,\"largest\":[", (unsigned long long)getPeakResidentBytes());
+            for (size_t i = 0; i < largest.size(); ++i)
+            {
+                fprintf(s.json, "%s{\"map\":%u,\"x\":%u,\"y\":%u,\"worker\":%u,\"heapPeak\":%llu,\"allocs\":%llu}", i ? "," : "",
+                    largest[i].mapId, largest[i].tileX, largest[i].tileY, largest[i].worker,
+                    (unsigned long long)largest[i].heapPeak, (unsigned long long)largest[i].allocs);
+            }
+            fprintf(s.json, "]");
+        }
+        fprintf(s.json, "}\n");
+        fclose(s.json);
+        s.json = NULL;
+    }
+}
+
+void addTelemetryWork(uint32 count)
+{
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.queued += count;
+}
+
+uint32 getTelemetryWorkerId()
+{
+    static thread_local TelemetryWorkerId worker;
+    if (worker.id == uint32(-1))
+    {
+        TelemetryState& s = state();
+        std::lock_guard<std::mutex> guard(s.lock);
+        if (s.freeWorkerIds.empty())
+        {
+            worker.id = s.nextWorkerId++;
+        }
+        else
+        {
+            // Lowest free id, so the worker table stays as short as the pool
+            std::vector<uint32>::iterator lowest = std::min_element(s.freeWorkerIds.begin(), s.freeWorkerIds.end());
+            worker.id = *lowest;
+            s.freeWorkerIds.erase(lowest);
+        }
+    }
+    return worker.id;
+}
+
+TelemetryCounter::TelemetryCounter(char const* name, TelemetryUnit unit) : m_name(name), m_unit(unit), m_value(0)
+{
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.counters.push_back(this);
+}
+
+TelemetryPhase::TelemetryPhase(char const* name) : m_name(name), m_start(TelemetryClock::now()), m_trace(name)
+{
+    uint64 rss = 0;
+    if (CONF_telemetryMemory)
+    {
+        m_memAtStart = getProcessMemory();
+        rss = getResidentBytes();
+    }
+
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    m_tilesAtStart = s.done;
+    m_outerPhase = s.phase;
+    s.phase = m_name;
+    s.rssPeak = rss;
+}
+
+TelemetryPhase::~TelemetryPhase()
+{
+    MemoryCounters mem;
+    uint64 rss = 0;
+    if (CONF_telemetryMemory)
+    {
+        mem = getProcessMemory();
+        rss = getResidentBytes();
+    }
+
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    s.phase = m_outerPhase;
+
+    TelemetryClock::time_point now = TelemetryClock::now();
+    PhaseSample phase;
+    phase.name = m_name;
+    phase.seconds = secondsSince(m_start, now);
+    phase.tiles = s.done - m_tilesAtStart;
+    phase.allocs = mem.allocs - m_memAtStart.allocs;
+    phase.bytes = mem.bytes - m_memAtStart.bytes;
+    phase.rssPeak = std::max(s.rssPeak, rss);
+    phase.rssEnd = rss;
+    s.phases.push_back(phase);
+
+    if (s.json)
+    {
+        beginJsonEvent(s, "phase", now);
+        fprintf(s.json, ",\"name\":\"%s\",\"seconds\":%.6f,\"tiles\":%llu,\"tilesPerSec\":%.3f", phase.name,
+            phase.seconds, (unsigned long long)phase.tiles, phase.seconds > 0.0 ? phase.tiles / phase.seconds : 0.0);
+        if (CONF_telemetryMemory)
+        {
+            fprintf(s.json, ",\"allocs\":%llu,\"bytes\":%llu,\"peakRss\":%llu,\"rss\":%llu",
+                (unsigned long long)phase.allocs, (unsigned long long)phase.bytes,
+                (unsigned long long)phase.rssPeak, (unsigned long long)phase.rssEnd);
+        }
+        fprintf(s.json, "}\n");
+    }
+}
+
+TelemetryTile::TelemetryTile(uint32 mapId, uint32 tileX, uint32 tileY, uint32 queueDepth)
+    : m_mapId(mapId), m_tileX(tileX), m_tileY(tileY), m_queueDepth(queueDepth), m_worker(getTelemetryWorkerId()),
+      m_ok(true), m_split(false), m_start(TelemetryClock::now()), m_trace("tile", mapId, tileX, tileY)
+{
+    ++t_openTiles;
+    if (CONF_telemetryMemory)
+    {
+        resetThreadMemoryPeak();
+        m_memAtStart = getThreadMemory();
+    }
+}
+
+TelemetryTile::~TelemetryTile()
+{
+    TelemetryClock::time_point now = TelemetryClock::now();
+    uint32 worker = m_worker;
+    --t_openTiles;
+
+    TileSample sample;
+    sample.seconds = secondsSince(m_start, now);
+    sample.mapId = m_mapId;
+    sample.tileX = m_tileX;
+    sample.tileY = m_tileY;
+    sample.worker = worker;
+    sample.allocs = 0;
+    sample.heapPeak = 0;
+
+    uint64 rss = 0;
+    bool heapSampled = CONF_telemetryMemory && !m_split;
+    if (heapSampled)
+    {
+        MemoryCounters mem = getThreadMemory();
+        sample.allocs = mem.allocs - m_memAtStart.allocs;
+        sample.heapPeak = mem.peak > m_memAtStart.live ? uint64(mem.peak - m_memAtStart.live) : 0;
+    }
+    if (CONF_telemetryMemory)
+    {
+        rss = getResidentBytes();
+    }
+
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    ++s.done;
+    if (!m_ok)
+    {
+        ++s.failed;
+    }
+    s.lastQueueDepth = m_queueDepth;
+
+    if (worker >= s.workers.size())
+    {
+        s.workers.resize(worker + 1);
+    }
+    ++s.workers[worker].tiles;
+    s.workers[worker].busy += sample.seconds;
+    if (heapSampled)
+    {
+        s.workers[worker].heapPeak = std::max(s.workers[worker].heapPeak, sample.heapPeak);
+        s.workers[worker].heapSampled = true;
+    }
+    s.rssPeak = std::max(s.rssPeak, rss);
+
+    if (CONF_telemetrySlowest)
+    {
+        keepTop(s.slowest, sample, slowerThan);
+        if (heapSampled)
+        {
+            keepTop(s.largest, sample, largerThan);
+        }
+    }
+
+    if (s.json)
+    {
+        beginJsonEvent(s, "tile", now);
+        fprintf(s.json, ",\"map\":%u,\"x\":%u,\"y\":%u,\"worker\":%u,\"seconds\":%.6f,\"queue\":%u,\"ok\":%s",
+            m_mapId, m_tileX, m_tileY, worker, sample.seconds, m_queueDepth, m_ok ? "true" : "false");
+        if (heapSampled)
+        {
+            fprintf(s.json, ",\"allocs\":%llu,\"heapPeak\":%llu",
+                (unsigned long long)sample.allocs, (unsigned long long)sample.heapPeak);
+        }
+        if (CONF_telemetryMemory)
+        {
+            fprintf(s.json, ",\"rss\":%llu", (unsigned long long)rss);
+        }
+        fprintf(s.json, "}\n");
+    }
+}
+
+TelemetrySubTask::TelemetrySubTask() : m_counted(t_openTiles == 0), m_start(TelemetryClock::now())
+{
+}
+
+TelemetrySubTask::~TelemetrySubTask()
+{
+    if (!m_counted)
+    {
+        return;
+    }
+
+    double seconds = secondsSince(m_start, TelemetryClock::now());
+    uint32 worker = getTelemetryWorkerId();
+
+    TelemetryState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (worker >= s.workers.size())
+    {
+        s.workers.resize(worker + 1);
+    }
+    s.workers[worker].busy += seconds;
+}
@@ -0,0 +1,299 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MANGOS_H_EXTRACTOR_TELEMETRY
+#define MANGOS_H_EXTRACTOR_TELEMETRY
+
+#include <atomic>
+#include <chrono>
+#include "loadlib.h"
+#include "ExtractorMemory.h"
+#include "ExtractorTrace.h"
+
+/**
+ * Progress and throughput telemetry shared by the extractors.
+ *
+ * Each tool wraps its pipeline steps in TelemetryPhase scopes and every unit of
+ * tile work in a TelemetryTile scope. From that the telemetry derives phase
+ * timers, tiles/sec, per-tile wall time per worker, queue depth and the slowest
+ * tiles. A progress line is printed every few seconds by a ticker thread, also
+ * during phases that do not finish tiles, a summary is printed by
+ * shutdownTelemetry(), and with --telemetry-json every event is also appended
+ * to a JSON lines file. Phases and tiles also show up as spans in the --trace
+ * timeline. With --telemetry-memory phases additionally report allocations and
+ * peak RSS, and tiles the peak heap of the worker that built them.
+ * Tools can also declare TelemetryCounter totals, such as files written or
+ * time spent waiting for a lock, which are added to the summary.
+ */
+
+/**
+ * @brief Parses the telemetry options shared by all extractors
+ *
+ * @param argc
+ * @param argv
+ * @param i index of the current argument, advanced past any option value
+ * @param ok set to false when a recognized option is missing its value
+ * @return bool true if argv[i] was a telemetry option
+ */
+bool handleTelemetryArgs(int argc, char** argv, int& i, bool& ok);
+
+/**
+ * @brief Prints the usage lines of the telemetry options
+ *
+ */
+void printTelemetryUsage();
+
+/**
+ * @brief Starts the telemetry clock, the progress ticker and opens the JSON lines file, if any
+ *
+ * @param tool name of the tool, written into every JSON event
+ */
+void initTelemetry(char const* tool);
+
+/**
+ * @brief Stops the progress ticker, prints the summary and closes the JSON lines file
+ *
+ */
+void shutdownTelemetry();
+
+/**
+ * @brief Announces tiles that were queued, so progress can show totals
+ *
+ * @param count
+ */
+void addTelemetryWork(uint32 count);
+
+/**
+ * @brief Small id of the calling worker thread, 0 for the first thread seen
+ *
+ * The id goes back to a free list when the thread exits and the next new
+ * thread takes the lowest free one, so threads started per map or pass reuse
+ * the ids of the threads they replace.
+ *
+ * @return uint32
+ */
+uint32 getTelemetryWorkerId();
+
+/**
+ * @brief What a TelemetryCounter counts, which decides how it is printed
+ */
+enum TelemetryUnit
+{
+    TELEMETRY_COUNT,                                        ///< plain number
+    TELEMETRY_BYTES,                                        ///< bytes, printed in MB
+    TELEMETRY_TIME                                          ///< nanoseconds summed over all threads, printed in seconds
+};
+
+/**
+ * @brief A total listed in the summary and the JSON summary event
+ *
+ * Counters are meant to be globals; they register themselves when they are
+ * constructed and are listed in that order. add() is safe from any thread.
+ */
+class TelemetryCounter
+{
+    public:
+        /**
+         * @brief
+         * @param name must outlive the counter, normally a string literal
+         * @param unit
+         */
+        explicit TelemetryCounter(char const* name, TelemetryUnit unit = TELEMETRY_COUNT);
+
+        /**
+         * @brief
+         * @param value
+         */
+        void add(uint64 value) { m_value.fetch_add(value, std::memory_order_relaxed); }
+
+        /**
+         * @brief
+         * @return uint64
+         */
+        uint64 get() const { return m_value.load(std::memory_order_relaxed); }
+
+        char const* getName() const { return m_name; }
+        TelemetryUnit getUnit() const { return m_unit; }
+
+    private:
+        TelemetryCounter(TelemetryCounter const&);
+        TelemetryCounter& operator=(TelemetryCounter const&);
+
+        char const* m_name;                                 /**< Counter name */
+        TelemetryUnit m_unit;                               /**< What the value counts */
+        std::atomic<uint64> m_value;                        /**< Running total */
+};
+
+/**
+ * @brief Adds the time until stop() or the end of the scope to a TELEMETRY_TIME counter
+ */
+class TelemetryTimer
+{
+    public:
+        /**
+         * @brief
+         * @param counter
+         */
+        explicit TelemetryTimer(TelemetryCounter& counter) : m_counter(&counter), m_start(std::chrono::steady_clock::now()) {}
+
+        /**
+         * @brief
+         */
+        ~TelemetryTimer() { stop(); }
+
+        /**
+         * @brief Stops the timer before the end of the scope
+         */
+        void stop()
+        {
+            if (m_counter)
+            {
+                m_counter->add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+                m_counter = NULL;
+            }
+        }
+
+    private:
+        TelemetryTimer(TelemetryTimer const&);
+        TelemetryTimer& operator=(TelemetryTimer const&);
+
+        TelemetryCounter* m_counter;                        /**< Counter to add to, NULL once stopped */
+        std::chrono::steady_clock::time_point m_start;      /**< Timer start */
+};
+
+/**
+ * @brief Times one pipeline phase for the lifetime of the scope
+ *
+ */
+class TelemetryPhase
+{
+    public:
+        /**
+         * @brief
+         *
+         * @param name must outlive the scope, normally a string literal
+         */
+        explicit TelemetryPhase(char const* name);
+
+        /**
+         * @brief
+         *
+         */
+        ~TelemetryPhase();
+
+    private:
+        TelemetryPhase(TelemetryPhase const&);
+        TelemetryPhase& operator=(TelemetryPhase const&);
+
+        char const* m_name;                                 /**< Phase name */
+        char const* m_outerPhase;                           /**< Phase running when this one began */
+        std::chrono::steady_clock::time_point m_start;      /**< Phase start */
+        uint64 m_tilesAtStart;                              /**< Tiles finished before the phase began */
+        MemoryCounters m_memAtStart;                        /**< Process allocation counters at start */
+        TraceScope m_trace;                                 /**< Timeline span of the phase */
+};
+
+/**
+ * @brief Times the conversion of one tile for the lifetime of the scope
+ *
+ */
+class TelemetryTile
+{
+    public:
+        /**
+         * @brief
+         *
+         * @param mapId
+         * @param tileX
+         * @param tileY
+         * @param queueDepth work items still queued when this tile was taken
+         */
+        TelemetryTile(uint32 mapId, uint32 tileX, uint32 tileY, uint32 queueDepth);
+
+        /**
+         * @brief
+         *
+         */
+        ~TelemetryTile();
+
+        /**
+         * @brief Marks the tile as failed
+         *
+         */
+        void fail() { m_ok = false; }
+
+        /**
+         * @brief Marks the tile as built partly on other workers, in TelemetrySubTask scopes
+         *
+         * Their allocations are counted by the workers running them, so the
+         * tile reports no allocations or peak heap of its own.
+         */
+        void splitAcrossWorkers() { m_split = true; }
+
+    private:
+        TelemetryTile(TelemetryTile const&);
+        TelemetryTile& operator=(TelemetryTile const&);
+
+        uint32 m_mapId;                                     /**< Map of the tile */
+        uint32 m_tileX;                                     /**< Tile X */
+        uint32 m_tileY;                                     /**< Tile Y */
+        uint32 m_queueDepth;                                /**< Queue depth at start */
+        uint32 m_worker;                                    /**< Worker id, taken at start while the thread holds it */
+        bool m_ok;                                          /**< Tile converted successfully */
+        bool m_split;                                       /**< Part of the tile runs on other workers */
+        std::chrono::steady_clock::time_point m_start;      /**< Tile start */
+        MemoryCounters m_memAtStart;                        /**< Worker allocation counters at start */
+        TraceScope m_trace;                                 /**< Timeline span of the tile */
+};
+
+/**
+ * @brief Times a part of a split tile for the busy time of the worker running it
+ *
+ * See TelemetryTile::splitAcrossWorkers(). On the thread of a tile itself the
+ * scope adds nothing, since the tile already counts that time.
+ */
+class TelemetrySubTask
+{
+    public:
+        /**
+         * @brief
+         *
+         */
+        TelemetrySubTask();
+
+        /**
+         * @brief
+         *
+         */
+        ~TelemetrySubTask();
+
+    private:
+        TelemetrySubTask(TelemetrySubTask const&);
+        TelemetrySubTask& operator=(TelemetrySubTask const&);
+
+        bool m_counted;                                     /**< Runs outside a tile of this thread */
+        std::chrono::steady_clock::time_point m_start;      /**< Sub-task start */
+};
+
+#endif
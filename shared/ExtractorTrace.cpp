@@ -0,0 +1,251 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "ExtractorTrace.h"
+#include "ExtractorTelemetry.h"
+
+bool g_traceEnabled = false;
+
+static char const* CONF_traceFile = NULL;       ///< Chrome trace output file
+static uint32 CONF_traceEvents = 1 << 16;       ///< Ring size per thread, rounded up to a power of two
+
+namespace
+{
+    /// One finished span
+    struct TraceEvent
+    {
+        char const* name;
+        uint64 start;
+        uint64 end;
+        int32 mapId;
+        int32 tileX;
+        int32 tileY;
+    };
+
+    /// Span buffer of one thread. Only the owning thread writes it; when full
+    /// the oldest spans are overwritten.
+    struct TraceRing
+    {
+        TraceRing(uint32 id, uint32 size) : tid(id), mask(size - 1), events(size), head(0) {}
+
+        uint32 tid;
+        uint32 mask;
+        std::vector<TraceEvent> events;
+        std::atomic<uint64> head;       ///< spans written so far
+    };
+
+    std::chrono::steady_clock::time_point sTraceEpoch;
+    std::mutex sRingsLock;              ///< guards sRings and sFreeRings, taken once per thread
+    std::vector<TraceRing*> sRings;
+    std::vector<TraceRing*> sFreeRings; ///< rings of threads that have exited
+    std::atomic<bool> sTraceWritten(false);
+
+    /// Hands the ring of a thread back when the thread exits, so the tools
+    /// that start new threads for every map keep one ring per worker slot
+    /// instead of one per thread ever started
+    struct TraceRingOwner
+    {
+        TraceRingOwner() : ring(NULL) {}
+        ~TraceRingOwner()
+        {
+            if (ring)
+            {
+                std::lock_guard<std::mutex> guard(sRingsLock);
+                sFreeRings.push_back(ring);
+            }
+        }
+
+        TraceRing* ring;
+    };
+
+    TraceRing* threadRing()
+    {
+        static thread_local TraceRingOwner owner;
+        if (!owner.ring)
+        {
+            std::lock_guard<std::mutex> guard(sRingsLock);
+            if (!sFreeRings.empty())
+            {
+                owner.ring = sFreeRings.back();
+                sFreeRings.pop_back();
+            }
+            else
+            {
+                owner.ring = new TraceRing(uint32(sRings.size()), CONF_traceEvents);
+                sRings.push_back(owner.ring);
+            }
+        }
+        return owner.ring;
+    }
+
+    uint64 traceNow()
+    {
+        return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - sTraceEpoch).count());
+    }
+}
+
+bool handleTraceArgs(int argc, char** argv, int& i, bool& ok)
+{
+    if (strcmp(argv[i], "--trace") == 0)
+    {
+        if (i + 1 >= argc)
+        {
+            ok = false;
+            return true;
+        }
+        CONF_traceFile = argv[++i];
+        g_traceEnabled = true;
+        return true;
+    }
+    if (strcmp(argv[i], "--trace-buffer") == 0)
+    {
+        if (i + 1 >= argc)
+        {
+            ok = false;
+            return true;
+        }
+        uint32 size = 1;
+        uint32 wanted = uint32(atoi(argv[++i]));
+        while (size < wanted && size < (1u << 31))
+        {
+            size <<= 1;
+        }
+        CONF_traceEvents = size;
+        return true;
+    }
+    return false;
+}
+
+void printTraceUsage()
+{
+    printf("   --trace <file>            record a Chrome/Perfetto timeline of all worker\n");
+    printf("                             threads into file\n");
+    printf("   --trace-buffer #          spans kept per thread (default 65536)\n");
+}
+
+void initTrace()
+{
+    sTraceEpoch = std::chrono::steady_clock::now();
+}
+
+void writeTrace()
+{
+    if (!g_traceEnabled || sTraceWritten.exchange(true))
+    {
+        return;
+    }
+
+    FILE* out = fopen(CONF_traceFile, "w");
+    if (!out)
+    {
+        printf("Can not create the trace file '%s'\n", CONF_traceFile);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(sRingsLock);
+
+    uint64 dropped = 0;
+    bool first = true;
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t r = 0; r < sRings.size(); ++r)
+    {
+        TraceRing const* ring = sRings[r];
+        uint64 head = ring->head.load(std::memory_order_acquire);
+        uint64 size = uint64(ring->mask) + 1;
+        uint64 tail = head > size ? head - size : 0;
+        dropped += tail;
+
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+            first ? "" : ",\n", ring->tid, ring->tid);
+        first = false;
+
+        for (uint64 i = tail; i < head; ++i)
+        {
+            TraceEvent const& e = ring->events[i & ring->mask];
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"extractor\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                e.name, ring->tid, e.start / 1000.0, (e.end - e.start) / 1000.0);
+            if (e.mapId >= 0)
+            {
+                fprintf(out, ",\"args\":{\"map\":%d,\"x\":%d,\"y\":%d}", e.mapId, e.tileX, e.tileY);
+            }
+            fprintf(out, "}");
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+
+    printf(" Trace written to %s", CONF_traceFile);
+    if (dropped)
+    {
+        printf(" (%llu oldest spans dropped, raise --trace-buffer to keep them)", (unsigned long long)dropped);
+    }
+    printf("\n");
+}
+
+void TraceScope::begin(char const* name, int mapId, int tileX, int tileY)
+{
+    m_name = name;
+    m_mapId = mapId;
+    m_tileX = tileX;
+    m_tileY = tileY;
+    m_start = traceNow();
+}
+
+void TraceScope::end()
+{
+    TraceRing* ring = threadRing();
+    uint64 head = ring->head.load(std::memory_order_relaxed);
+
+    TraceEvent& e = ring->events[head & ring->mask];
+    e.name = m_name;
+    e.start = m_start;
+    e.end = traceNow();
+    e.mapId = m_mapId;
+    e.tileX = m_tileX;
+    e.tileY = m_tileY;
+
+    ring->head.store(head + 1, std::memory_order_release);
+    m_name = NULL;
+}
+
+TracedLock::TracedLock(std::mutex& mutex, char const* waitName, TelemetryCounter* waitTime) : m_mutex(mutex), m_owns(true)
+{
+    TraceScope wait(waitName);
+    if (waitTime)
+    {
+        TelemetryTimer timer(*waitTime);
+        m_mutex.lock();
+    }
+    else
+    {
+        m_mutex.lock();
+    }
+}
@@ -0,0 +1,200 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MANGOS_H_EXTRACTOR_TRACE
+#define MANGOS_H_EXTRACTOR_TRACE
+
+#include <mutex>
+#include "loadlib.h"
+
+class TelemetryCounter;
+
+/**
+ * Opt-in timeline tracer shared by the extractors.
+ *
+ * With --trace <file> every TraceScope records a begin/end span into a ring
+ * buffer owned by the calling thread. A thread that exits hands its ring to the
+ * next new thread, so a ring stands for a worker slot rather than one thread.
+ * Recording takes no lock: only the owning thread writes its ring, and the
+ * rings are read once, after the workers are gone, when writeTrace() turns them into Chrome trace-event JSON that can be
+ * opened in chrome://tracing or ui.perfetto.dev. Without --trace a scope costs
+ * a single branch.
+ */
+
+extern bool g_traceEnabled; ///< set by handleTraceArgs, read by every TraceScope
+
+/**
+ * @brief Parses the --trace options
+ *
+ * @param argc
+ * @param argv
+ * @param i index of the current argument, advanced past any option value
+ * @param ok set to false when a recognized option is missing its value
+ * @return bool true if argv[i] was a trace option
+ */
+bool handleTraceArgs(int argc, char** argv, int& i, bool& ok);
+
+/**
+ * @brief Prints the usage lines of the trace options
+ *
+ */
+void printTraceUsage();
+
+/**
+ * @brief Starts the trace clock
+ *
+ */
+void initTrace();
+
+/**
+ * @brief Writes all recorded spans to the trace file, once
+ *
+ * Called at the end of main() once the workers have stopped. A run that ends
+ * through exit() writes no trace, since workers may still be recording.
+ */
+void writeTrace();
+
+/**
+ * @brief Records one span from construction to destruction
+ *
+ */
+class TraceScope
+{
+    public:
+        /**
+         * @brief
+         *
+         * @param name must stay valid until writeTrace(), normally a string literal
+         */
+        explicit TraceScope(char const* name) : m_name(NULL)
+        {
+            if (g_traceEnabled)
+            {
+                begin(name, -1, -1, -1);
+            }
+        }
+
+        /**
+         * @brief Span tagged with the tile it works on
+         *
+         * @param name
+         * @param mapId
+         * @param tileX
+         * @param tileY
+         */
+        TraceScope(char const* name, int mapId, int tileX, int tileY) : m_name(NULL)
+        {
+            if (g_traceEnabled)
+            {
+                begin(name, mapId, tileX, tileY);
+            }
+        }
+
+        /**
+         * @brief
+         *
+         */
+        ~TraceScope()
+        {
+            if (m_name)
+            {
+                end();
+            }
+        }
+
+        /**
+         * @brief Ends the current span and starts the next stage right away
+         *
+         * @param name
+         */
+        void next(char const* name)
+        {
+            if (m_name)
+            {
+                end();
+                begin(name, m_mapId, m_tileX, m_tileY);
+            }
+        }
+
+    private:
+        TraceScope(TraceScope const&);
+        TraceScope& operator=(TraceScope const&);
+
+        void begin(char const* name, int mapId, int tileX, int tileY);
+        void end();
+
+        char const* m_name;     /**< Span name, NULL when not recording */
+        uint64 m_start;         /**< Start in ns since initTrace() */
+        int m_mapId;            /**< Map argument, -1 for none */
+        int m_tileX;            /**< Tile X argument */
+        int m_tileY;            /**< Tile Y argument */
+};
+
+/**
+ * @brief Lock that records the time spent waiting for the mutex as a span
+ *
+ */
+class TracedLock
+{
+    public:
+        /**
+         * @brief
+         *
+         * @param mutex
+         * @param waitName span name for the wait
+         * @param waitTime TELEMETRY_TIME counter the wait is also added to, may be NULL
+         */
+        TracedLock(std::mutex& mutex, char const* waitName, TelemetryCounter* waitTime = NULL);
+
+        /**
+         * @brief
+         *
+         */
+        ~TracedLock()
+        {
+            unlock();
+        }
+
+        /**
+         * @brief Releases the mutex before the end of the scope
+         *
+         */
+        void unlock()
+        {
+            if (m_owns)
+            {
+                m_mutex.unlock();
+                m_owns = false;
+            }
+        }
+
+    private:
+        TracedLock(TracedLock const&);
+        TracedLock& operator=(TracedLock const&);
+
+        std::mutex& m_mutex;    /**< Guarded mutex */
+        bool m_owns;            /**< Mutex is currently held */
+};
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <iterator>
+#include "WorkerPool.h"
+
+/// Index of the pool worker running on this thread, -1 on other threads
+static thread_local int t_workerIndex = -1;
+
+/// Pool that owns the worker running on this thread
+static thread_local WorkerPool const* t_workerPool = NULL;
+
+WorkerPool::WorkerPool(uint32 nThreads) : m_queued(0), m_unfinished(0), m_nextQueue(0), m_stop(false)
+{
+    if (!nThreads)
+    {
+        nThreads = std::thread::hardware_concurrency();
+    }
+    if (nThreads <= 1)
+    {
+        return;
+    }
+
+    m_queues.reserve(nThreads);
+    for (uint32 i = 0; i < nThreads; ++i)
+    {
+        m_queues.push_back(new TaskQueue());
+    }
+    m_threads.reserve(nThreads);
+    for (uint32 i = 0; i < nThreads; ++i)
+    {
+        m_threads.emplace_back(&WorkerPool::run, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+    for (size_t i = 0; i < m_queues.size(); ++i)
+    {
+        delete m_queues[i];
+    }
+}
+
+void WorkerPool::submit(Task const& task)
+{
+    push(task, NULL);
+}
+
+void WorkerPool::submit(Task const& task, TaskGroup& group)
+{
+    push(task, &group);
+}
+
+void WorkerPool::push(Task const& task, TaskGroup* group)
+{
+    if (m_threads.empty())
+    {
+        // Serial path: run it here
+        task();
+        return;
+    }
+
+    uint32 index;
+    if (t_workerPool == this)
+    {
+        index = uint32(t_workerIndex);
+    }
+    else
+    {
+        index = m_nextQueue.fetch_add(1) % m_queues.size();
+    }
+
+    if (group)
+    {
+        ++group->m_pending;
+    }
+    ++m_unfinished;
+    {
+        // Counted under m_lock, so a worker checking for work before it
+        // sleeps cannot miss this task
+        std::lock_guard<std::mutex> lock(m_lock);
+        ++m_queued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->lock);
+        m_queues[index]->tasks.push_back(QueuedTask(task, group));
+    }
+    m_wake.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_idle.wait(lock, [this] { return m_unfinished.load() == 0; });
+}
+
+void WorkerPool::wait(TaskGroup& group)
+{
+    QueuedTask task;
+    while (group.m_pending.load())
+    {
+        if (popGroupTask(group, task))
+        {
+            task.task();
+            finishTask(task.group);
+            task = QueuedTask();
+            continue;
+        }
+
+        // The rest of the group is running on other threads
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_idle.wait(lock, [&group] { return group.m_pending.load() == 0; });
+    }
+}
+
+void WorkerPool::run(uint32 index)
+{
+    t_workerIndex = int(index);
+    t_workerPool = this;
+
+    QueuedTask task;
+    while (true)
+    {
+        if (popTask(index, task))
+        {
+            task.task();
+            finishTask(task.group);
+            task = QueuedTask();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_wake.wait(lock, [this] { return m_stop || m_queued.load() > 0; });
+        if (m_stop && m_queued.load() <= 0)
+        {
+            return;
+        }
+    }
+}
+
+bool WorkerPool::popTask(uint32 index, QueuedTask& task)
+{
+    // Oldest task of our own queue first
+    {
+        TaskQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            --m_queued;
+            return true;
+        }
+    }
+
+    // Then steal the newest task of the next worker that has one
+    for (size_t i = 1; i < m_queues.size(); ++i)
+    {
+        TaskQueue& other = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(other.lock);
+        if (!other.tasks.empty())
+        {
+            task = other.tasks.back();
+            other.tasks.pop_back();
+            --m_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkerPool::popGroupTask(TaskGroup& group, QueuedTask& task)
+{
+    // Our own queue first, where a task filling its group put the tasks,
+    // newest first like a thief
+    uint32 index = t_workerPool == this ? uint32(t_workerIndex) : 0;
+    for (size_t i = 0; i < m_queues.size(); ++i)
+    {
+        TaskQueue& queue = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        for (std::deque<QueuedTask>::reverse_iterator it = queue.tasks.rbegin(); it != queue.tasks.rend(); ++it)
+        {
+            if (it->group == &group)
+            {
+                task = *it;
+                queue.tasks.erase(std::next(it).base());
+                --m_queued;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WorkerPool::finishTask(TaskGroup* group)
+{
+    // The group may be gone as soon as its count drops, so it is not
+    // touched after that
+    if (group && --group->m_pending == 0)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_idle.notify_all();
+    }
+    if (--m_unfinished == 0)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_idle.notify_all();
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MANGOS_H_WORKER_POOL
+#define MANGOS_H_WORKER_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "loadlib.h"
+
+/**
+ * Persistent work-stealing thread pool shared by the extractors.
+ *
+ * Each worker owns a task queue. Tasks submitted from outside the pool are
+ * dealt round robin over the queues, tasks submitted by a worker go to its own
+ * queue. A worker takes the oldest task of its own queue and, once that is
+ * empty, steals the newest task of another worker, so a long map or tile on
+ * one queue does not leave the other workers idle. The threads live until the
+ * pool is destroyed, so work of many maps can be fed to the same workers
+ * without starting and joining threads per map. A task can hand parts of
+ * its own work to the pool as a TaskGroup and wait for them.
+ */
+class WorkerPool
+{
+    public:
+        typedef std::function<void()> Task; /**< TODO */
+
+        /**
+         * @brief Tasks that can be waited for apart from the rest of the pool
+         *
+         * A task can split its work into a group and wait for it. The waiting
+         * thread runs the queued tasks of the group itself, and then blocks
+         * only until the tasks of the group that other workers already took
+         * have finished.
+         */
+        class TaskGroup
+        {
+            public:
+                TaskGroup() : m_pending(0) {}
+
+            private:
+                friend class WorkerPool;
+
+                TaskGroup(TaskGroup const&);
+                TaskGroup& operator=(TaskGroup const&);
+
+                std::atomic<uint32> m_pending;  ///< tasks of the group submitted and not yet finished
+        };
+
+        /**
+         * @brief Starts the workers
+         *
+         * @param nThreads number of workers; 0 = one per core, 1 = no workers,
+         *        every task runs inside submit() on the calling thread
+         */
+        explicit WorkerPool(uint32 nThreads);
+
+        /**
+         * @brief Runs the remaining tasks, then stops and joins the workers
+         *
+         */
+        ~WorkerPool();
+
+        /**
+         * @brief Queues a task
+         *
+         * @param task
+         */
+        void submit(Task const& task);
+
+        /**
+         * @brief Queues a task of a group
+         *
+         * @param task
+         * @param group
+         */
+        void submit(Task const& task, TaskGroup& group);
+
+        /**
+         * @brief Blocks until every task submitted so far has finished
+         *
+         * Must not be called from a task.
+         */
+        void wait();
+
+        /**
+         * @brief Runs queued tasks of the group until all of them have finished
+         *
+         * May be called from a task. Tasks of the group must not add to it.
+         *
+         * @param group
+         */
+        void wait(TaskGroup& group);
+
+        /**
+         * @brief Tasks queued and not yet started, for the telemetry queue depth
+         *
+         * @return uint32
+         */
+        uint32 getPending() const { return uint32(m_queued.load()); }
+
+        /**
+         * @brief Number of worker threads, 0 when tasks run inline
+         *
+         * @return uint32
+         */
+        uint32 getThreadCount() const { return uint32(m_threads.size()); }
+
+    private:
+        WorkerPool(WorkerPool const&);
+        WorkerPool& operator=(WorkerPool const&);
+
+        /**
+         * @brief A queued task and the group it belongs to
+         *
+         */
+        struct QueuedTask
+        {
+            QueuedTask() : group(NULL) {}
+            QueuedTask(Task const& t, TaskGroup* g) : task(t), group(g) {}
+
+            Task task;                  /**< TODO */
+            TaskGroup* group;           ///< NULL for tasks outside a group
+        };
+
+        /**
+         * @brief Task queue of one worker
+         *
+         */
+        struct TaskQueue
+        {
+            std::mutex lock;                ///< guards tasks
+            std::deque<QueuedTask> tasks;   /**< TODO */
+        };
+
+        void push(Task const& task, TaskGroup* group);
+        void run(uint32 index);
+        bool popTask(uint32 index, QueuedTask& task);
+        bool popGroupTask(TaskGroup& group, QueuedTask& task);
+        void finishTask(TaskGroup* group);
+
+        std::vector<TaskQueue*> m_queues;       /**< TODO */
+        std::vector<std::thread> m_threads;     /**< TODO */
+        std::mutex m_lock;                      ///< guards m_stop and the sleep/idle waits
+        std::condition_variable m_wake;         ///< signalled when a task is queued or the pool stops
+        std::condition_variable m_idle;         ///< signalled when the last unfinished task, or that of a group, is done
+        std::atomic<int> m_queued;              ///< tasks queued and not yet taken
+        std::atomic<uint32> m_unfinished;       ///< tasks submitted and not yet finished
+        std::atomic<uint32> m_nextQueue;        ///< round robin position for outside submits
+        bool m_stop;                            /**< TODO */
+};
+
+#endif
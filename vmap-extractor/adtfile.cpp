@@ -26,18 +26,23 @@
 #include <cstdio>
 #include "vmapexport.h"
 #include "adtfile.h"
+#include <ExtractorTrace.h>
+
+/// Path scratch of the MMDX/MWMO parsing, keeps its storage between names and tiles
+static thread_local std::string t_chunkPath;
 
 ADTFile::ADTFile(char* filename): AdtFilename(filename)
 {
 }
 
-bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failedPaths,int iCoreNumber, const void *szRawVMAPMagic)
+bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failedPaths, std::vector<char>& dirBuffer, int iCoreNumber, const void *szRawVMAPMagic)
 {
     HANDLE adtHandle;
 
     // The archive open + read race the shared StormLib file position, so hold
     // the MPQ lock around them; the in-memory parse that follows is unlocked.
-    std::unique_lock<std::mutex> mpqLock(g_mpqReadMutex);
+    TraceScope stage("adt read");
+    TracedLock mpqLock(g_mpqReadMutex, "mpq lock wait", &g_mpqLockWait);
     if (!OpenNewestFile(AdtFilename.c_str(), &adtHandle))
     {
         printf("Error initializing ADT %s\n", AdtFilename.c_str());
@@ -50,6 +55,7 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failed
     {
         return false;
     }
+    stage.next("adt parse");
 
     uint32 size;
 
@@ -67,21 +73,8 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failed
 
     std::string AdtMapNumber = xMap + ' ' + yMap + ' ' + GetUniformName(filename);
 
-    // Write this tile's placement records to a per-tile temp file rather than
-    // the shared dir_bin. A placement is several fwrites, so concurrent tiles
-    // sharing one handle would interleave (corrupt) records. ParseMapFiles
-    // concatenates these temps into dir_bin in tile order afterwards.
-    char tileSuffix[32];
-    sprintf(tileSuffix, "/dir_bin.%u_%u", tileX, tileY);
-    std::string dirname = std::string(szWorkDirWmo) + tileSuffix;
-    FILE* dirfile;
-    dirfile = fopen(dirname.c_str(), "ab");
-    if (!dirfile)
-    {
-        printf("Can't open dirfile!'%s'\n", dirname.c_str());
-        return false;
-    }
-
+    // Placement records go to this tile's own buffer; ParseMapFiles merges
+    // the buffers into dir_bin in tile order once the map is done.
     while (!ADT.isEof())
     {
         char fourcc[5];
@@ -102,38 +95,33 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failed
         {
             if (size)
             {
-                char* buf = new char[size];
-                ADT.read(buf, size);
-                char* p = buf;
-                int t = 0;
-                ModelInstansName = new std::string[size];
-                while (p < buf + size)
+                // Names are parsed in place and stored as pointers to the
+                // interned uniform names, so no per-name allocation is made.
+                char const* p = ADT.getPointer();
+                char const* end = p + std::min<size_t>(size, ADT.getSize() - ADT.getPos());
+                ModelInstansName.clear();
+                ModelInstansName.reserve(CountChunkNames(p, end));
+                while (NextChunkName(p, end, t_chunkPath))
                 {
-                    std::string path(p);                         // Store copy after name fixed
-                    std::string uName;
-                    ExtractSingleModel(path, uName, failedPaths, iCoreNumber, szRawVMAPMagic);
-                    ModelInstansName[t++] = uName;
-                    p = p + strlen(p) + 1;
+                    std::string const* uName;
+                    TelemetryTimer extractTime(g_tileModelTime);
+                    ExtractSingleModel(t_chunkPath, uName, failedPaths, iCoreNumber, szRawVMAPMagic);
+                    ModelInstansName.push_back(uName);
                 }
-                delete[] buf;
             }
         }
         else if (!strcmp(fourcc, "MWMO"))
         {
             if (size)
             {
-                char* buf = new char[size];
-                ADT.read(buf, size);
-                char* p = buf;
-                int q = 0;
-                WmoInstansName = new std::string[size];
-                while (p < buf + size)
+                char const* p = ADT.getPointer();
+                char const* end = p + std::min<size_t>(size, ADT.getSize() - ADT.getPos());
+                WmoInstansName.clear();
+                WmoInstansName.reserve(CountChunkNames(p, end));
+                while (NextChunkName(p, end, t_chunkPath))
                 {
-                    std::string path(p);
-                    WmoInstansName[q++] = GetUniformName(path);
-                    p = p + strlen(p) + 1;
+                    WmoInstansName.push_back(GetInternedUniformName(t_chunkPath));
                 }
-                delete[] buf;
             }
         }
         //======================
@@ -141,35 +129,34 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failed
         {
             if (size)
             {
+                TelemetryTimer placementTime(g_tilePlacementTime);
                 nMDX = (int)size / 36;
                 for (int i = 0; i < nMDX; ++i)
                 {
                     uint32 id;
                     ADT.read(&id, 4);
-                    ModelInstance inst(ADT, ModelInstansName[id], map_num, tileX, tileY, dirfile, iCoreNumber);
+                    ModelInstance inst(ADT, GetChunkName(ModelInstansName, id), map_num, tileX, tileY, dirBuffer, iCoreNumber);
                 }
-                delete[] ModelInstansName;
             }
         }
         else if (!strcmp(fourcc, "MODF"))
         {
             if (size)
             {
+                TelemetryTimer placementTime(g_tilePlacementTime);
                 nWMO = (int)size / 64;
                 for (int i = 0; i < nWMO; ++i)
                 {
                     uint32 id;
                     ADT.read(&id, 4);
-                    WMOInstance inst(ADT, WmoInstansName[id], map_num, tileX, tileY, dirfile);
+                    WMOInstance inst(ADT, GetChunkName(WmoInstansName, id), map_num, tileX, tileY, dirBuffer);
                 }
-                delete[] WmoInstansName;
             }
         }
         //======================
         ADT.seek(nextpos);
     }
     ADT.close();
-    fclose(dirfile);
 
     return true;
 }
@@ -160,8 +160,8 @@ class ADTFile
         ~ADTFile();
         int nWMO; /**< TODO */
         int nMDX; /**< TODO */
-        string* WmoInstansName; /**< TODO */
-        string* ModelInstansName; /**< TODO */
+        ChunkNames WmoInstansName; /**< TODO */
+        ChunkNames ModelInstansName; /**< TODO */
 
         /**
          * @brief
@@ -170,9 +170,10 @@ class ADTFile
          * @param tileX
          * @param tileY
          * @param failedPaths
+         * @param dirBuffer receives this tile's dir_bin placement records
          * @return bool
          */
-        bool init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failedPaths,int iCoreNumber, const void *szRawVMAPMagic);
+        bool init(uint32 map_num, uint32 tileX, uint32 tileY, StringSet& failedPaths, std::vector<char>& dirBuffer, int iCoreNumber, const void *szRawVMAPMagic);
     private:
         string AdtFilename; /**< TODO */
 };
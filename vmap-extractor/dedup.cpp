@@ -0,0 +1,269 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+#include "dedup.h"
+#include "journal.h"
+#include "vec3d.h"
+#include "vmapexport.h"
+#include <BinaryWriter.h>
+#include <WorkerPool.h>
+
+/// mapID, tileX, tileY, flags, adtId, id, pos, rot, scale: the part of a placement before the optional bounds
+static size_t const PLACEMENT_SIZE = 4 * sizeof(uint32) + sizeof(uint16) + sizeof(uint32) + 2 * sizeof(Vec3D) + sizeof(float);
+
+static std::string WorkPath(std::string const& name)
+{
+    return std::string(szWorkDirWmo) + "/" + name;
+}
+
+/**
+ * @brief Size and MD5 of a file's contents, as a key for std::map
+ *
+ * @param data
+ * @return std::string
+ */
+static std::string PayloadDigest(std::vector<char> const& data)
+{
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(data.empty() ? NULL : &data[0], data.size(), digest, &length, EVP_md5(), NULL);
+
+    char key[32 + 2 * EVP_MAX_MD_SIZE];
+    int pos = sprintf(key, "%llu-", (unsigned long long)data.size());
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        pos += sprintf(key + pos, "%02x", digest[i]);
+    }
+    return key;
+}
+
+static bool SameContents(std::string const& name1, std::string const& name2)
+{
+    std::vector<char> data1, data2;
+    return ReadWholeFile(WorkPath(name1), data1) && ReadWholeFile(WorkPath(name2), data2) && data1 == data2;
+}
+
+/**
+ * @brief Replaces a file by new contents, written beside it first
+ *
+ * @param name
+ * @param data
+ * @return bool
+ */
+static bool RewriteWorkFile(std::string const& name, std::vector<char> const& data)
+{
+    std::string path = WorkPath(name);
+    std::string temp = path + ".new";
+    FILE* out = fopen(temp.c_str(), "wb");
+    if (!out)
+    {
+        return false;
+    }
+    bool written = data.empty() || fwrite(&data[0], 1, data.size(), out) == data.size();
+    written = fclose(out) == 0 && written;
+#ifdef WIN32
+    remove(path.c_str());
+#endif
+    return written && rename(temp.c_str(), path.c_str()) == 0;
+}
+
+static std::string const& CanonicalName(std::map<std::string, std::string> const& copies, std::string const& name)
+{
+    std::map<std::string, std::string>::const_iterator itr = copies.find(name);
+    return itr != copies.end() ? itr->second : name;
+}
+
+/**
+ * @brief Renames the placements in dir_bin that name a copy
+ *
+ * @param copies kept file by the name of each copy
+ * @return bool
+ */
+static bool RenamePlacements(std::map<std::string, std::string> const& copies)
+{
+    std::vector<char> dirBin;
+    if (!ReadWholeFile(WorkPath("dir_bin"), dirBin))
+    {
+        return true;                                            // no placements at all
+    }
+
+    std::vector<char> renamed;
+    renamed.reserve(dirBin.size());
+    BinaryWriter out(renamed);
+    size_t pos = 0;
+    while (pos < dirBin.size())
+    {
+        if (dirBin.size() - pos < PLACEMENT_SIZE)
+        {
+            printf(" %s/dir_bin ends in a partial placement\n", szWorkDirWmo);
+            return false;
+        }
+        uint32 flags;
+        memcpy(&flags, &dirBin[pos + 3 * sizeof(uint32)], sizeof(flags));
+        size_t fixedSize = PLACEMENT_SIZE + ((flags & MOD_HAS_BOUND) ? 2 * sizeof(Vec3D) : 0);
+        uint32 nlen;
+        if (dirBin.size() - pos < fixedSize + sizeof(nlen))
+        {
+            printf(" %s/dir_bin ends in a partial placement\n", szWorkDirWmo);
+            return false;
+        }
+        memcpy(&nlen, &dirBin[pos + fixedSize], sizeof(nlen));
+        if (dirBin.size() - pos - fixedSize - sizeof(nlen) < nlen)
+        {
+            printf(" %s/dir_bin ends in a partial placement\n", szWorkDirWmo);
+            return false;
+        }
+
+        std::string const& name = CanonicalName(copies, std::string(&dirBin[pos + fixedSize + sizeof(nlen)], nlen));
+        out.putBytes(&dirBin[pos], fixedSize);
+        out.put(uint32(name.length()));
+        out.putSpan(name.c_str(), name.length());
+        pos += fixedSize + sizeof(nlen) + nlen;
+    }
+
+    if (!RewriteWorkFile("dir_bin", renamed))
+    {
+        printf(" Can't rewrite %s/dir_bin\n", szWorkDirWmo);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Renames the models in temp_gameobject_models that are a copy
+ *
+ * @param copies kept file by the name of each copy
+ * @return bool
+ */
+static bool RenameGameobjectModels(std::map<std::string, std::string> const& copies)
+{
+    std::vector<char> list;
+    if (!ReadWholeFile(WorkPath("temp_gameobject_models"), list))
+    {
+        return true;
+    }
+
+    // displayId, name length, name
+    std::vector<char> renamed;
+    renamed.reserve(list.size());
+    BinaryWriter out(renamed);
+    size_t pos = 0;
+    while (list.size() - pos >= 2 * sizeof(uint32))
+    {
+        uint32 nlen;
+        memcpy(&nlen, &list[pos + sizeof(uint32)], sizeof(nlen));
+        if (list.size() - pos - 2 * sizeof(uint32) < nlen)
+        {
+            break;
+        }
+
+        std::string const& name = CanonicalName(copies, std::string(&list[pos + 2 * sizeof(uint32)], nlen));
+        out.putBytes(&list[pos], sizeof(uint32));
+        out.put(uint32(name.length()));
+        out.putSpan(name.c_str(), name.length());
+        pos += 2 * sizeof(uint32) + nlen;
+    }
+
+    if (!RewriteWorkFile("temp_gameobject_models", renamed))
+    {
+        printf(" Can't rewrite %s/temp_gameobject_models\n", szWorkDirWmo);
+        return false;
+    }
+    return true;
+}
+
+bool DeduplicateModels(uint32 nThreads)
+{
+    printf("\n");
+    printf("Merging identical model files...\n");
+
+    std::vector<std::string> names;
+    ListDirFiles(szWorkDirWmo, names);
+    names.erase(std::remove_if(names.begin(), names.end(), [](std::string const& name) { return !IsRawModelName(name); }), names.end());
+    std::sort(names.begin(), names.end());
+
+    std::vector<std::string> digests(names.size());
+    {
+        WorkerPool pool(nThreads);
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            pool.submit([&names, &digests, i]()
+            {
+                std::vector<char> data;
+                if (ReadWholeFile(WorkPath(names[i]), data))
+                {
+                    digests[i] = PayloadDigest(data);
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    // Names are sorted, so the first file of each digest is the one kept
+    std::map<std::string, size_t> kept;
+    std::map<std::string, std::string> copies;
+    uint64 savedBytes = 0;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (digests[i].empty())
+        {
+            continue;
+        }
+        std::pair<std::map<std::string, size_t>::iterator, bool> first = kept.insert(std::make_pair(digests[i], i));
+        if (!first.second && SameContents(names[first.first->second], names[i]))
+        {
+            copies[names[i]] = names[first.first->second];
+            savedBytes += strtoull(digests[i].c_str(), NULL, 10);
+        }
+    }
+
+    if (copies.empty())
+    {
+        printf(" No identical model files among %u\n", uint32(names.size()));
+        return true;
+    }
+
+    // Once dir_bin is renamed, a resumed run must not cut it back to its journaled size
+    journalDeduplication();
+    if (!RenamePlacements(copies) || !RenameGameobjectModels(copies))
+    {
+        return false;
+    }
+
+    for (std::map<std::string, std::string>::const_iterator itr = copies.begin(); itr != copies.end(); ++itr)
+    {
+        remove(WorkPath(itr->first).c_str());
+    }
+
+    printf(" Removed %u of %u model files as copies, %llu bytes\n",
+           uint32(copies.size()), uint32(names.size()), (unsigned long long)savedBytes);
+    return true;
+}
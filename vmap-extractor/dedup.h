@@ -0,0 +1,47 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <loadlib.h>
+
+/**
+ * @brief Keeps one copy of raw model files with identical contents
+ *
+ * The client ships many M2 and WMO files more than once, under different
+ * directories, and each copy becomes a raw file of its own. Once the
+ * extraction is complete, every raw file in the building directory is
+ * hashed; files with the same size and digest are compared byte by byte.
+ * Of each set of identical files the one with the lowest name is kept, so
+ * the result does not depend on the order of extraction. Placements in
+ * dir_bin and the gameobject model list are renamed to the kept file before
+ * the others are deleted.
+ *
+ * @param nThreads threads hashing the files; 0 = one per core
+ * @return bool false if dir_bin or the gameobject model list cannot be rewritten
+ */
+bool DeduplicateModels(uint32 nThreads);
+
+#endif
@@ -0,0 +1,287 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include "journal.h"
+#include "vmapexport.h"
+
+static std::mutex s_journalMutex;                               ///< guards the journal state below
+static FILE* s_journal = NULL;                                  /**< TODO */
+static std::vector<std::pair<uint32, uint64> > s_journaledMaps; ///< map id and dir_bin size, in append order
+static std::map<uint32, FILE*> s_tileSpools;                    ///< open tile spools by map id
+static bool s_deduplicated = false;                             ///< dir_bin was rewritten by DeduplicateModels()
+
+static std::string WorkPath(std::string const& name)
+{
+    return std::string(szWorkDirWmo) + "/" + name;
+}
+
+static std::string TileSpoolPath(uint32 mapId)
+{
+    char name[32];
+    sprintf(name, "tiles_%04u.journal", mapId);
+    return WorkPath(name);
+}
+
+bool openJournal(bool resume)
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+
+    std::set<std::string> files;
+    s_journaledMaps.clear();
+    s_deduplicated = false;
+    if (resume)
+    {
+        if (FILE* in = fopen(WorkPath("journal").c_str(), "rb"))
+        {
+            char line[1024];
+            while (fgets(line, sizeof(line), in))
+            {
+                size_t len = strlen(line);
+                if (!len || line[len - 1] != '\n')
+                {
+                    break;                                      // cut short by the interruption
+                }
+                line[len - 1] = '\0';
+
+                uint32 mapId;
+                unsigned long long dirBinSize;
+                if (!strncmp(line, "file ", 5))
+                {
+                    files.insert(line + 5);
+                }
+                else if (sscanf(line, "map %u %llu", &mapId, &dirBinSize) == 2)
+                {
+                    s_journaledMaps.push_back(std::make_pair(mapId, uint64(dirBinSize)));
+                }
+                else if (!strcmp(line, "dedup"))
+                {
+                    s_deduplicated = true;
+                }
+            }
+            fclose(in);
+        }
+
+        // Cut dir_bin back to the end of the last journaled map. Once the
+        // duplicates were merged the sizes are stale, but every map is done.
+        uint64 dirBinSize = s_journaledMaps.empty() ? 0 : s_journaledMaps.back().second;
+        std::vector<char> dirBin;
+        ReadWholeFile(WorkPath("dir_bin"), dirBin);
+        if (s_deduplicated)
+        {
+            dirBinSize = dirBin.size();
+        }
+        if (dirBin.size() < dirBinSize)
+        {
+            printf(" %s/dir_bin is shorter than its journal, the extraction cannot be resumed.\n", szWorkDirWmo);
+            return false;
+        }
+        if (dirBin.size() > dirBinSize)
+        {
+            FILE* out = fopen(WorkPath("dir_bin").c_str(), "wb");
+            if (!out || (dirBinSize && fwrite(&dirBin[0], 1, size_t(dirBinSize), out) != dirBinSize))
+            {
+                printf(" Can't rewrite %s/dir_bin\n", szWorkDirWmo);
+                if (out)
+                {
+                    fclose(out);
+                }
+                return false;
+            }
+            fclose(out);
+        }
+
+        // Raw files without a journal line may have been cut short
+        std::vector<std::string> names;
+        ListDirFiles(szWorkDirWmo, names);
+        uint32 removed = 0;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (IsRawModelName(names[i]) && !files.count(names[i]))
+            {
+                remove(WorkPath(names[i]).c_str());
+                ++removed;
+            }
+        }
+
+        printf(" Resuming: %u model files and %u maps done, %u unfinished files removed\n",
+               uint32(files.size()), uint32(s_journaledMaps.size()), removed);
+    }
+
+    // Write the journal anew with the valid lines only; a line cut short
+    // would otherwise swallow the first one appended after it.
+    s_journal = fopen(WorkPath("journal").c_str(), "wb");
+    if (!s_journal)
+    {
+        printf(" Can't create %s/journal\n", szWorkDirWmo);
+        return false;
+    }
+    for (std::set<std::string>::const_iterator itr = files.begin(); itr != files.end(); ++itr)
+    {
+        fprintf(s_journal, "file %s\n", itr->c_str());
+    }
+    for (size_t i = 0; i < s_journaledMaps.size(); ++i)
+    {
+        fprintf(s_journal, "map %u %llu\n", s_journaledMaps[i].first, (unsigned long long)s_journaledMaps[i].second);
+    }
+    if (s_deduplicated)
+    {
+        fprintf(s_journal, "dedup\n");
+    }
+    fflush(s_journal);
+    return true;
+}
+
+void closeJournal()
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+    for (std::map<uint32, FILE*>::iterator itr = s_tileSpools.begin(); itr != s_tileSpools.end(); ++itr)
+    {
+        fclose(itr->second);
+    }
+    s_tileSpools.clear();
+    if (s_journal)
+    {
+        fclose(s_journal);
+        s_journal = NULL;
+    }
+}
+
+void journalFile(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+    if (s_journal)
+    {
+        fprintf(s_journal, "file %s\n", name.c_str());
+        fflush(s_journal);
+    }
+}
+
+bool isMapJournaled(uint32 mapId)
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+    for (size_t i = 0; i < s_journaledMaps.size(); ++i)
+    {
+        if (s_journaledMaps[i].first == mapId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void journalMap(uint32 mapId, uint64 dirBinSize)
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+    if (s_journal)
+    {
+        fprintf(s_journal, "map %u %llu\n", mapId, (unsigned long long)dirBinSize);
+        fflush(s_journal);
+    }
+    s_journaledMaps.push_back(std::make_pair(mapId, dirBinSize));
+
+    // The map's tiles are in dir_bin now
+    std::map<uint32, FILE*>::iterator itr = s_tileSpools.find(mapId);
+    if (itr != s_tileSpools.end())
+    {
+        fclose(itr->second);
+        s_tileSpools.erase(itr);
+    }
+    remove(TileSpoolPath(mapId).c_str());
+}
+
+void loadJournaledTiles(uint32 mapId, std::map<std::pair<int, int>, std::vector<char> >& tiles)
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+
+    std::vector<char> spool;
+    if (!ReadWholeFile(TileSpoolPath(mapId), spool))
+    {
+        return;
+    }
+
+    // Records are x, y, size and the placement bytes; keep the complete ones
+    size_t pos = 0;
+    while (pos + 3 * sizeof(uint32) <= spool.size())
+    {
+        uint32 header[3];
+        memcpy(header, &spool[pos], sizeof(header));
+        if (spool.size() - pos - sizeof(header) < header[2])
+        {
+            break;
+        }
+        char const* data = &spool[pos + sizeof(header)];
+        tiles[std::make_pair(int(header[0]), int(header[1]))].assign(data, data + header[2]);
+        pos += sizeof(header) + header[2];
+    }
+
+    // Drop a record cut short, so the tiles spooled from now on follow the
+    // last complete one
+    FILE* out = fopen(TileSpoolPath(mapId).c_str(), "wb");
+    if (out)
+    {
+        if (pos)
+        {
+            fwrite(&spool[0], 1, pos, out);
+        }
+        fflush(out);
+        s_tileSpools[mapId] = out;
+    }
+}
+
+void journalTile(uint32 mapId, int x, int y, std::vector<char> const& placements)
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+    FILE*& spool = s_tileSpools[mapId];
+    if (!spool)
+    {
+        spool = fopen(TileSpoolPath(mapId).c_str(), "ab");
+        if (!spool)
+        {
+            s_tileSpools.erase(mapId);
+            return;
+        }
+    }
+    uint32 header[3] = { uint32(x), uint32(y), uint32(placements.size()) };
+    fwrite(header, sizeof(header), 1, spool);
+    if (!placements.empty())
+    {
+        fwrite(&placements[0], 1, placements.size(), spool);
+    }
+    fflush(spool);
+}
+
+void journalDeduplication()
+{
+    std::lock_guard<std::mutex> lock(s_journalMutex);
+    s_deduplicated = true;
+    if (s_journal)
+    {
+        fprintf(s_journal, "dedup\n");
+        fflush(s_journal);
+    }
+}
@@ -0,0 +1,119 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <loadlib.h>
+
+/**
+ * Progress journal of the vmap extraction, so an interrupted run can resume.
+ *
+ * The journal in the work directory is a text file with one line per
+ * finished piece of work: a raw model or WMO file that was written
+ * completely, or a map whose placements were appended to dir_bin, together
+ * with the size of dir_bin after that map. The placement records of every
+ * parsed tile of the map in progress are spooled to tiles_<map>.journal
+ * until the map reaches dir_bin.
+ *
+ * With --resume, openJournal() checks the work directory against the
+ * journal. It deletes raw files that are not journaled, because they may be
+ * cut short. It truncates dir_bin back to the last journaled map and drops
+ * spooled tile records that were cut short. Journaled files, maps and tiles
+ * are then skipped by the extraction.
+ *
+ * A "dedup" line records that DeduplicateModels() started on the finished
+ * extraction.
+ */
+
+/**
+ * @brief Opens the journal in the work directory
+ *
+ * @param resume load and validate the journal of an earlier run instead of starting a new one
+ * @return bool false if the work directory cannot be resumed
+ */
+bool openJournal(bool resume);
+
+/**
+ * @brief
+ *
+ */
+void closeJournal();
+
+/**
+ * @brief Records a raw model or WMO file that has been written completely
+ *
+ * @param name uniform name of the file
+ */
+void journalFile(std::string const& name);
+
+/**
+ * @brief Test if an earlier run already appended the placements of a map to dir_bin
+ *
+ * @param mapId
+ * @return bool
+ */
+bool isMapJournaled(uint32 mapId);
+
+/**
+ * @brief Records that the placements of a map have been appended to dir_bin
+ *
+ * Also drops the tiles spooled for the map.
+ *
+ * @param mapId
+ * @param dirBinSize size of dir_bin after the append
+ */
+void journalMap(uint32 mapId, uint64 dirBinSize);
+
+/**
+ * @brief Placement records of the tiles of a map parsed by an earlier run
+ *
+ * @param mapId
+ * @param tiles receives the records by tile x, y
+ */
+void loadJournaledTiles(uint32 mapId, std::map<std::pair<int, int>, std::vector<char> >& tiles);
+
+/**
+ * @brief Spools the placement records of a parsed tile
+ *
+ * @param mapId
+ * @param x
+ * @param y
+ * @param placements
+ */
+void journalTile(uint32 mapId, int x, int y, std::vector<char> const& placements);
+
+/**
+ * @brief Records that duplicate model files are about to be merged
+ *
+ * Placements in dir_bin get renamed, so from now on the journaled sizes of
+ * dir_bin no longer hold; a resumed run keeps dir_bin as it is.
+ */
+void journalDeduplication();
+
+#endif
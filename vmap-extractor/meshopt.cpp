@@ -0,0 +1,238 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include "meshopt.h"
+#include "vertexkernels.h"
+
+static std::atomic<uint64> s_verticesIn(0);     /**< TODO */
+static std::atomic<uint64> s_verticesOut(0);    /**< TODO */
+static std::atomic<uint64> s_trianglesIn(0);    /**< TODO */
+static std::atomic<uint64> s_trianglesOut(0);   /**< TODO */
+
+static std::mutex s_quantizeMutex;              ///< guards the quantization error below
+static uint64 s_quantizedVertices = 0;          /**< TODO */
+static double s_quantizeErrorSum = 0.0;         /**< TODO */
+static float s_quantizeErrorMax = 0.0f;         /**< TODO */
+
+/**
+ * @brief Grid cell a vertex is welded in
+ *
+ */
+struct WeldCell
+{
+    int64 x, y, z;
+
+    bool operator==(WeldCell const& other) const
+    {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+/**
+ * @brief
+ *
+ */
+struct WeldCellHash
+{
+    size_t operator()(WeldCell const& cell) const
+    {
+        return size_t(cell.x * 73856093) ^ size_t(cell.y * 19349663) ^ size_t(cell.z * 83492791);
+    }
+};
+
+static WeldCell GetWeldCell(float const* position)
+{
+    WeldCell cell;
+    cell.x = int64(std::floor(position[0] / MESH_WELD_CELL));
+    cell.y = int64(std::floor(position[1] / MESH_WELD_CELL));
+    cell.z = int64(std::floor(position[2] / MESH_WELD_CELL));
+    return cell;
+}
+
+static float TriangleAreaSq(float const* a, float const* b, float const* c)
+{
+    float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    float n[3] =
+    {
+        e1[1] * e2[2] - e1[2] * e2[1],
+        e1[2] * e2[0] - e1[0] * e2[2],
+        e1[0] * e2[1] - e1[1] * e2[0]
+    };
+    // |e1 x e2| is twice the area
+    return 0.25f * (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+}
+
+void OptimizeCollisionMesh(std::vector<float>& vertices, std::vector<uint16>& indices)
+{
+    uint32 nVertices = uint32(vertices.size() / 3);
+    uint32 nTriangles = uint32(indices.size() / 3);
+
+    // weld: the first vertex in a cell stands for all others in it
+    std::vector<float> welded;
+    welded.reserve(vertices.size());
+    std::vector<uint32> weldIndex(nVertices);
+    std::unordered_map<WeldCell, uint32, WeldCellHash> cells;
+    cells.reserve(nVertices);
+    for (uint32 i = 0; i < nVertices; ++i)
+    {
+        float const* position = &vertices[3 * i];
+        std::pair<std::unordered_map<WeldCell, uint32, WeldCellHash>::iterator, bool> cell =
+            cells.insert(std::make_pair(GetWeldCell(position), uint32(welded.size() / 3)));
+        if (cell.second)
+        {
+            welded.insert(welded.end(), position, position + 3);
+        }
+        weldIndex[i] = cell.first->second;
+    }
+
+    // drop triangles that collapsed or repeat an earlier one
+    std::vector<uint32> triangles;
+    triangles.reserve(3 * nTriangles);
+    std::unordered_set<uint64> seen;
+    seen.reserve(nTriangles);
+    for (uint32 i = 0; i < nTriangles; ++i)
+    {
+        if (indices[3 * i] >= nVertices || indices[3 * i + 1] >= nVertices || indices[3 * i + 2] >= nVertices)
+        {
+            continue;
+        }
+        uint32 corner[3] = { weldIndex[indices[3 * i]], weldIndex[indices[3 * i + 1]], weldIndex[indices[3 * i + 2]] };
+        if (corner[0] == corner[1] || corner[1] == corner[2] || corner[0] == corner[2])
+        {
+            continue;
+        }
+        if (TriangleAreaSq(&welded[3 * corner[0]], &welded[3 * corner[1]], &welded[3 * corner[2]]) < MESH_MIN_AREA * MESH_MIN_AREA)
+        {
+            continue;
+        }
+
+        // rotate the lowest index to the front, which keeps the winding; the
+        // welded ordinals get 21 bits each, so the key is exact up to 2M vertices
+        int first = corner[0] < corner[1] ? (corner[0] < corner[2] ? 0 : 2) : (corner[1] < corner[2] ? 1 : 2);
+        uint64 key = (uint64(corner[first]) << 42) | (uint64(corner[(first + 1) % 3]) << 21) | uint64(corner[(first + 2) % 3]);
+        if (!seen.insert(key).second)
+        {
+            continue;
+        }
+        triangles.insert(triangles.end(), corner, corner + 3);
+    }
+
+    // number the vertices in order of first use
+    std::vector<int32> order(welded.size() / 3, -1);
+    vertices.clear();
+    indices.clear();
+    indices.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        uint32 index = triangles[i];
+        if (order[index] < 0)
+        {
+            order[index] = int32(vertices.size() / 3);
+            vertices.insert(vertices.end(), &welded[3 * index], &welded[3 * index] + 3);
+        }
+        indices.push_back(uint16(order[index]));
+    }
+
+    s_verticesIn += nVertices;
+    s_verticesOut += vertices.size() / 3;
+    s_trianglesIn += nTriangles;
+    s_trianglesOut += indices.size() / 3;
+}
+
+void printMeshOptimizationSummary()
+{
+    printf(" Mesh optimization kept %llu of %llu vertices and %llu of %llu triangles\n",
+           (unsigned long long)s_verticesOut, (unsigned long long)s_verticesIn,
+           (unsigned long long)s_trianglesOut, (unsigned long long)s_trianglesIn);
+}
+
+float MeasureQuantizationError(float const* vertices, uint32 nVertices, float const* bbMin, float const* bbMax)
+{
+    if (!nVertices)
+    {
+        return 0.0f;
+    }
+
+    float lo[3], hi[3];
+    GetVertexBounds(vertices, nVertices, lo, hi);
+    if (bbMin)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis] = std::min(std::min(bbMin[axis], bbMax[axis]), lo[axis]);
+            hi[axis] = std::max(std::max(bbMin[axis], bbMax[axis]), hi[axis]);
+        }
+    }
+
+    float centre[3], step[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        centre[axis] = 0.5f * (lo[axis] + hi[axis]);
+        step[axis] = 0.5f * (hi[axis] - lo[axis]) / 32767.0f;
+    }
+
+    float maxError = 0.0f;
+    double errorSum = 0.0;
+    for (uint32 i = 0; i < nVertices; ++i)
+    {
+        float const* position = &vertices[3 * i];
+        float moved = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (step[axis] <= 0.0f)
+            {
+                continue;
+            }
+            float offset = std::floor((position[axis] - centre[axis]) / step[axis] + 0.5f);
+            offset = std::max(-32767.0f, std::min(32767.0f, offset));
+            float snapped = centre[axis] + offset * step[axis];
+            moved += (snapped - position[axis]) * (snapped - position[axis]);
+        }
+        moved = std::sqrt(moved);
+        maxError = std::max(maxError, moved);
+        errorSum += moved;
+    }
+
+    std::lock_guard<std::mutex> guard(s_quantizeMutex);
+    s_quantizedVertices += nVertices;
+    s_quantizeErrorSum += errorSum;
+    s_quantizeErrorMax = std::max(s_quantizeErrorMax, maxError);
+    return maxError;
+}
+
+void printQuantizationSummary()
+{
+    std::lock_guard<std::mutex> guard(s_quantizeMutex);
+    printf(" Quantization would move %llu vertices by %.5f yards at most, %.5f on average\n",
+           (unsigned long long)s_quantizedVertices, s_quantizeErrorMax,
+           s_quantizedVertices ? s_quantizeErrorSum / s_quantizedVertices : 0.0);
+}
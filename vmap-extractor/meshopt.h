@@ -0,0 +1,88 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef MESHOPT_H
+#define MESHOPT_H
+
+#include <vector>
+#include <loadlib.h>
+
+/**
+ * Optional clean-up of the collision meshes written to the raw model files.
+ *
+ * Vertices are welded by snapping their positions to a grid of
+ * MESH_WELD_CELL and merging the ones that land in the same cell, through a
+ * hash map keyed on the cell. A welded vertex keeps the position of the
+ * first vertex seen in its cell. Triangles that lost a corner to the weld,
+ * that have (nearly) zero area, or that repeat an earlier triangle with the
+ * same winding are dropped. At last the vertices are renumbered in the order
+ * the triangles first use them, which drops unused vertices and keeps the
+ * vertices of neighbouring triangles close together.
+ *
+ * The error of quantizing the vertices to what an int16 encoding relative to
+ * the bounding box of the mesh would hold can also be measured. The written
+ * geometry stays float, since the vmap assembler reads no other encoding.
+ */
+
+#define MESH_WELD_CELL      (1.0f / 1024.0f)    ///< weld grid size, in yards
+#define MESH_MIN_AREA       (1.0e-6f)           ///< triangles with a smaller area are dropped, in square yards
+
+/**
+ * @brief Welds the vertices of a triangle mesh and drops degenerate and duplicate triangles
+ *
+ * @param vertices x, y, z of each vertex; replaced by the optimized vertices
+ * @param indices three vertex indices per triangle; replaced by the optimized triangles
+ */
+void OptimizeCollisionMesh(std::vector<float>& vertices, std::vector<uint16>& indices);
+
+/**
+ * @brief Prints how much the optimization removed over the whole extraction
+ *
+ */
+void printMeshOptimizationSummary();
+
+/**
+ * @brief Measures how far the vertices would move on the int16 grid of a bounding box
+ *
+ * Every axis of the box is split into 65534 steps around its centre, so a
+ * vertex could be stored as three int16 offsets from the centre. The box is
+ * grown to hold every vertex, which bounds the error of each axis to half a
+ * step. The vertices are left as they are; the largest and mean distance
+ * they would move are collected for printQuantizationSummary().
+ *
+ * @param vertices x, y, z of each vertex
+ * @param nVertices
+ * @param bbMin lower corner of the box, or NULL to use the bounds of the vertices
+ * @param bbMax upper corner of the box, or NULL to use the bounds of the vertices
+ * @return float largest distance a vertex moved
+ */
+float MeasureQuantizationError(float const* vertices, uint32 nVertices, float const* bbMin, float const* bbMax);
+
+/**
+ * @brief Prints the quantization error measured over the whole extraction
+ *
+ */
+void printQuantizationSummary();
+
+#endif
@@ -25,26 +25,36 @@
 #include <cassert>
 #include <algorithm>
 #include <cstdio>
-#include <condition_variable>
+#include <future>
 #include <mutex>
-#include <set>
+#include <vector>
 
 #include <mpq.h>
 #include "model.h"
 #include "wmo.h"
 #include "dbcfile.h"
+#include "DBCStructure.h"
 #include "vmapexport.h"
+#include "journal.h"
+#include "meshopt.h"
+#include "vertexkernels.h"
 #include <ExtractorCommon.h>
+#include <ExtractorTrace.h>
+#include <BinaryWriter.h>
+#include <WorkerPool.h>
+
+extern uint32 CONF_threads;
+extern bool CONF_optimizeMesh;
+extern bool CONF_quantizeReport;
+
+/// Output buffer of the model files written by this thread
+static thread_local std::vector<char> t_writeBuffer;
 
 // Dedup model extraction across parallel tile workers. The FileExists()-then-
 // write check is a TOCTOU race once tiles run concurrently. One worker extracts
 // a given model; the rest WAIT until its file is on disk, because the placement
-// written straight after (ModelInstance) opens that file and silently drops the
-// spawn if it is missing.
-static std::mutex s_modelExtractMutex;
-static std::condition_variable s_modelExtractCv;
-static std::set<std::string> s_modelsInProgress;
-static std::set<std::string> s_modelsDone;
+// written straight after (ModelInstance) drops the spawn if it is missing.
+static ExtractRegistry s_modelExtracts;
 
 Model::Model(std::string& filename) : filename(filename), vertices(0), indices(0), nIndices(0), boundingVertices(0), ok(false), headerClassicTBC(), headerOthers()
 {
@@ -53,7 +63,8 @@ Model::Model(std::string& filename) : filename(filename), vertices(0), indices(0
 bool Model::open(StringSet& failedPaths, int iCoreNumber)
 {
     HANDLE mpqHandle;
-    std::unique_lock<std::mutex> mpqLock(g_mpqReadMutex);
+    TraceScope trace("m2 read");
+    TracedLock mpqLock(g_mpqReadMutex, "mpq lock wait", &g_mpqLockWait);
     if (!OpenNewestFile(filename.c_str(), &mpqHandle))
     {
         printf("Error opening model file %s\n", filename.c_str());
@@ -130,7 +141,7 @@ bool Model::open(StringSet& failedPaths, int iCoreNumber)
     return true;
 }
 
-bool Model::ConvertToVMAPModel(std::string& outfilename,int iCoreNumber, const void *szRawVMAPMagic)
+bool Model::ConvertToVMAPModel(std::string& outfilename, uint32& nVertices, int iCoreNumber, const void *szRawVMAPMagic)
 {
     FILE* output = fopen(outfilename.c_str(), "wb");
     if (!output)
@@ -139,8 +150,9 @@ bool Model::ConvertToVMAPModel(std::string& outfilename,int iCoreNumber, const v
         return false;
     }
 
-    fwrite(szRawVMAPMagic, 8, 1, output);
-    uint32 nVertices = 0;
+    BinaryWriter out(t_writeBuffer, output);
+    out.putBytes(szRawVMAPMagic, 8);
+    nVertices = 0;
     if (iCoreNumber == CLIENT_CLASSIC || iCoreNumber == CLIENT_TBC)
     {
         nVertices = headerClassicTBC.nBoundingVertices;
@@ -149,93 +161,91 @@ bool Model::ConvertToVMAPModel(std::string& outfilename,int iCoreNumber, const v
     {
         nVertices = headerOthers.nBoundingVertices;
     }
-    fwrite(&nVertices, sizeof(int), 1, output);
+
+    // vmaps use the opposite winding
+    SwapTriangleWinding(indices, nIndices);
+
+    if (CONF_quantizeReport && nVertices > 0)
+    {
+        MeasureQuantizationError(reinterpret_cast<float const*>(vertices), nVertices, NULL, NULL);
+    }
+
+    Vec3D const* vertexData = vertices;
+    uint16 const* indexData = indices;
+    uint32 nIndexes = (uint32) nIndices;
+    std::vector<float> optVertices;
+    std::vector<uint16> optIndices;
+    if (CONF_optimizeMesh && nVertices > 0)
+    {
+        float const* positions = reinterpret_cast<float const*>(vertices);
+        optVertices.assign(positions, positions + 3 * nVertices);
+        optIndices.assign(indices, indices + nIndices);
+        OptimizeCollisionMesh(optVertices, optIndices);
+        nVertices = uint32(optVertices.size() / 3);
+        nIndexes = uint32(optIndices.size());
+        vertexData = reinterpret_cast<Vec3D const*>(optVertices.data());
+        indexData = optIndices.data();
+    }
+
+    out.put(nVertices);
     uint32 nofgroups = 1;
-    fwrite(&nofgroups, sizeof(uint32), 1, output);
+    out.put(nofgroups);
 
     uint32 rootwmoid = 0;
     uint32 mogpflags = 0;
     uint32 groupWMOID = 0;
-    fwrite(&rootwmoid, sizeof(uint32), 1, output);
-    fwrite(&mogpflags, sizeof(uint32), 1, output);
-    fwrite(&groupWMOID, sizeof(uint32), 1, output);
+    out.put(rootwmoid);
+    out.put(mogpflags);
+    out.put(groupWMOID);
 
     // Compute bounding box from actual vertices
     Vec3D bmin(0, 0, 0), bmax(0, 0, 0);
     if (nVertices > 0)
     {
-        bmin = vertices[0];
-        bmax = vertices[0];
-        for (size_t i = 1; i < nVertices; i++)
-        {
-            if (vertices[i].x < bmin.x)
-            {
-                bmin.x = vertices[i].x;
-            }
-            if (vertices[i].y < bmin.y)
-            {
-                bmin.y = vertices[i].y;
-            }
-            if (vertices[i].z < bmin.z)
-            {
-                bmin.z = vertices[i].z;
-            }
-            if (vertices[i].x > bmax.x)
-            {
-                bmax.x = vertices[i].x;
-            }
-            if (vertices[i].y > bmax.y)
-            {
-                bmax.y = vertices[i].y;
-            }
-            if (vertices[i].z > bmax.z)
-            {
-                bmax.z = vertices[i].z;
-            }
-        }
+        GetVertexBounds(reinterpret_cast<float const*>(vertexData), nVertices, &bmin.x, &bmax.x);
     }
-    fwrite(&bmin, sizeof(float) * 3, 1, output);
-    fwrite(&bmax, sizeof(float) * 3, 1, output);
+    out.put(bmin);
+    out.put(bmax);
 
     uint32 liquidflags = 0;
-    fwrite(&liquidflags, sizeof(uint32), 1, output);
-    fwrite("GRP ", 4, 1, output);
+    out.put(liquidflags);
+    out.putTag("GRP ");
     uint32 branches = 1;
     int wsize;
     wsize = sizeof(branches) + sizeof(uint32) * branches;
-    fwrite(&wsize, sizeof(int), 1, output);
-    fwrite(&branches, sizeof(branches), 1, output);
-    uint32 nIndexes = (uint32) nIndices;
-    fwrite(&nIndexes, sizeof(uint32), 1, output);
-    fwrite("INDX", 4, 1, output);
+    out.put(wsize);
+    out.put(branches);
+    out.put(nIndexes);
+    out.putTag("INDX");
     wsize = sizeof(uint32) + sizeof(unsigned short) * nIndexes;
-    fwrite(&wsize, sizeof(int), 1, output);
-    fwrite(&nIndexes, sizeof(uint32), 1, output);
+    out.put(wsize);
+    out.put(nIndexes);
     if (nIndexes > 0)
     {
-        for (uint32 i = 0; i + 2 < nIndices; i += 3)
-        {
-            uint16 tmp = indices[i + 1];
-            indices[i + 1] = indices[i + 2];
-            indices[i + 2] = tmp;
-        }
-        fwrite(indices, sizeof(unsigned short), nIndexes, output);
+        out.putSpan(indexData, nIndexes);
     }
-    fwrite("VERT", 4, 1, output);
+    out.putTag("VERT");
     wsize = sizeof(int) + sizeof(float) * 3 * nVertices;
-    fwrite(&wsize, sizeof(int), 1, output);
-    fwrite(&nVertices, sizeof(int), 1, output);
+    out.put(wsize);
+    out.put(nVertices);
     if (nVertices > 0)
     {
-        fwrite(vertices, sizeof(float) * 3, nVertices, output);
+        out.putSpan(vertexData, nVertices);
     }
 
+    bool written = out.flush();
+    g_bytesWritten.add(uint64(ftell(output)));
     fclose(output);
+    if (!written)
+    {
+        printf("Can't write the output file '%s'\n", outfilename.c_str());
+        return false;
+    }
 
     return true;
 }
 
-ModelInstance::ModelInstance(MPQFile& f, string& ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile, int coreNumber)
+ModelInstance::ModelInstance(MPQFile& f, string const& ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<char>& dirBuffer, int coreNumber)
 {
     float ff[3];
     f.read(&id, 4);
@@ -256,23 +266,8 @@ ModelInstance::ModelInstance(MPQFile& f, string& ModelInstName, uint32 mapID, ui
         sc = scaleZeroOnly / 1024.0f; // scale factor - divide by 1024. why not just use a float?
     }
 
-    char tempname[512];
-    sprintf(tempname, "%s/%s", szWorkDirWmo, ModelInstName.c_str());
-    FILE* input;
-    input = fopen(tempname, "r+b");
-
-    if (!input)
-    {
-        //printf("ModelInstance::ModelInstance couldn't open %s\n", tempname);
-        return;
-    }
-
-    fseek(input, 8, SEEK_SET); // get the correct no of vertices
-    int nVertices;
-    size_t file_read = fread(&nVertices, sizeof(int), 1, input);
-    fclose(input);
-
-    if (nVertices == 0 || file_read <= 0)
+    // Skips models that were not extracted (-1) or have no geometry
+    if (GetModelVertexCount(ModelInstName) <= 0)
     {
         return;
     }
@@ -284,22 +279,24 @@ ModelInstance::ModelInstance(MPQFile& f, string& ModelInstName, uint32 mapID, ui
         flags |= MOD_WORLDSPAWN;
     }
     //write mapID, tileX, tileY, Flags, ID, Pos, Rot, Scale, name
-    fwrite(&mapID, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileX, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileY, sizeof(uint32), 1, pDirfile);
-    fwrite(&flags, sizeof(uint32), 1, pDirfile);
-    fwrite(&adtId, sizeof(uint16), 1, pDirfile);
-    fwrite(&id, sizeof(uint32), 1, pDirfile);
-    fwrite(&pos, sizeof(float), 3, pDirfile);
-    fwrite(&rot, sizeof(float), 3, pDirfile);
-    fwrite(&sc, sizeof(float), 1, pDirfile);
+    BinaryWriter out(dirBuffer);
+    out.put(mapID);
+    out.put(tileX);
+    out.put(tileY);
+    out.put(flags);
+    out.put(adtId);
+    out.put(id);
+    out.put(pos);
+    out.put(rot);
+    out.put(sc);
     uint32 nlen = ModelInstName.length();
-    fwrite(&nlen, sizeof(uint32), 1, pDirfile);
-    fwrite(ModelInstName.c_str(), sizeof(char), nlen, pDirfile);
+    out.put(nlen);
+    out.putSpan(ModelInstName.c_str(), nlen);
+    g_placementsWritten.add(1);
 
 }
 
-bool ExtractSingleModel(std::string& origPath, std::string& fixedName, StringSet& failedPaths, int iCoreNumber, const void *szRawVMAPMagic)
+bool ExtractSingleModel(std::string& origPath, std::string const*& fixedName, StringSet& failedPaths, int iCoreNumber, const void *szRawVMAPMagic)
 {
     string ext = GetExtension(origPath);
 
@@ -313,43 +310,40 @@ bool ExtractSingleModel(std::string& origPath, std::string& fixedName, StringSet
     // >= 3.1.0 ADT MMDX section store filename.m2 filenames for corresponded .m2 file
     // nothing do
 
-    fixedName = GetUniformName(origPath);
+    fixedName = GetInternedUniformName(origPath);
+
+    std::promise<bool> extracted;
+    bool result;
+    if (!s_modelExtracts.claim(*fixedName, extracted, result, "model wait"))
+    {
+        g_modelsReused.add(1);
+        return result;
+    }
+
     std::string output(szWorkDirWmo);                       // Stores output filename
     output += "/";
-    output += fixedName;
+    output += *fixedName;
 
+    // Left over from a previous run
+    if (FileExists(output.c_str()))
     {
-        std::unique_lock<std::mutex> lock(s_modelExtractMutex);
-        if (s_modelsDone.count(fixedName))
-        {
-            return true;
-        }
-        if (s_modelsInProgress.count(fixedName))
-        {
-            // Another worker is extracting this model; block until its file is
-            // written so the placement that follows can read it.
-            s_modelExtractCv.wait(lock, [&] { return s_modelsDone.count(fixedName) != 0; });
-            return true;
-        }
-        if (FileExists(output.c_str()))
-        {
-            s_modelsDone.insert(fixedName);
-            return true;
-        }
-        // Claim it, then extract outside the lock so distinct models convert in
-        // parallel.
-        s_modelsInProgress.insert(fixedName);
+        g_modelsReused.add(1);
+        extracted.set_value(true);
+        return true;
     }
 
+    TraceScope trace("model convert");
     Model mdl(origPath);                                    // Possible changed fname
-    bool ok = mdl.open(failedPaths, iCoreNumber) && mdl.ConvertToVMAPModel(output, iCoreNumber, szRawVMAPMagic);
-
+    uint32 nVertices = 0;
+    bool ok = mdl.open(failedPaths, iCoreNumber) && mdl.ConvertToVMAPModel(output, nVertices, iCoreNumber, szRawVMAPMagic);
+    SetModelVertexCount(*fixedName, ok ? int(nVertices) : -1);
+    if (ok)
     {
-        std::lock_guard<std::mutex> lock(s_modelExtractMutex);
-        s_modelsInProgress.erase(fixedName);
-        s_modelsDone.insert(fixedName);
+        g_modelsConverted.add(1);
+        journalFile(*fixedName);
     }
-    s_modelExtractCv.notify_all();
+
+    extracted.set_value(ok);
     return ok;
 }
 
@@ -370,49 +364,87 @@ void ExtractGameobjectModels(int iCoreNumber, const void *szRawVMAPMagic)
         exit(1);
     }
 
+    DBCTable<GameObjectDisplayInfoEntry> displayInfo(dbc);
+    if (!displayInfo.isValid())
+    {
+        printf("Fatal error: Unexpected record size in GameObjectDisplayInfo.dbc!\n");
+        exit(1);
+    }
+
     std::string basepath = szWorkDirWmo;
     basepath += "/";
-    std::string path;
     StringSet failedPaths;
 
-    FILE* model_list = fopen((basepath + "temp_gameobject_models").c_str(), "wb");
-
-    for (DBCFile::Iterator it = dbc.begin(); it != dbc.end(); ++it)
+    // Rows are extracted by the pool; each keeps the uniform name of its
+    // model if one was written, so the list is built in DBC order after.
+    std::vector<std::string> rowNames(displayInfo.size());
+    std::mutex failedMutex;
+    WorkerPool pool(CONF_threads);
+    for (size_t i = 0; i < displayInfo.size(); ++i)
     {
-        path = it->getString(1);
-
-        if (path.length() < 4)
+        pool.submit([&, i]()
         {
-            continue;
-        }
+            GameObjectDisplayInfoEntry const& entry = displayInfo[i];
+            std::string path = displayInfo.getString(entry.ModelName);
 
-        string name;
+            if (path.length() < 4)
+            {
+                return;
+            }
 
-        string ch_ext = GetExtension(path);
-        if (ch_ext.empty())
-        {
-            continue;
-        }
+            string name;
 
-        bool result = false;
-        if (ch_ext == "wmo")
-        {
-            name = GetUniformName(path);
-            result = ExtractSingleWmo(path, iCoreNumber, szRawVMAPMagic);
-        }
-        else
-        {
-            result = ExtractSingleModel(path, name, failedPaths, iCoreNumber, szRawVMAPMagic);
-        }
+            string ch_ext = GetExtension(path);
+            if (ch_ext.empty())
+            {
+                return;
+            }
 
-        if (result && FileExists((basepath + name).c_str()))
+            bool result = false;
+            if (ch_ext == "wmo")
+            {
+                name = GetUniformName(path);
+                result = ExtractSingleWmo(path, pool, iCoreNumber, szRawVMAPMagic);
+            }
+            else
+            {
+                StringSet localFailed;
+                std::string const* fixedName;
+                result = ExtractSingleModel(path, fixedName, localFailed, iCoreNumber, szRawVMAPMagic);
+                name = *fixedName;
+                if (!localFailed.empty())
+                {
+                    std::lock_guard<std::mutex> lock(failedMutex);
+                    failedPaths.insert(localFailed.begin(), localFailed.end());
+                }
+            }
+
+            // The vertex count is known for every model extracted above, and
+            // is -1 when no file exists
+            if (result && GetModelVertexCount(name) >= 0)
+            {
+                rowNames[i] = name;
+            }
+        });
+    }
+    pool.wait();
+
+    FILE* model_list = fopen((basepath + "temp_gameobject_models").c_str(), "wb");
+
+    for (size_t i = 0; i < displayInfo.size(); ++i)
+    {
+        std::string const& name = rowNames[i];
+        if (name.empty())
         {
-            uint32 displayId = it->getUInt(0);
-            uint32 path_length = name.length();
-            fwrite(&displayId, sizeof(uint32), 1, model_list);
-            fwrite(&path_length, sizeof(uint32), 1, model_list);
-            fwrite(name.c_str(), sizeof(char), path_length, model_list);
+            continue;
         }
+
+        uint32 displayId = displayInfo[i].ID;
+        uint32 path_length = name.length();
+        fwrite(&displayId, sizeof(uint32), 1, model_list);
+        fwrite(&path_length, sizeof(uint32), 1, model_list);
+        fwrite(name.c_str(), sizeof(char), path_length, model_list);
+        g_bytesWritten.add(2 * sizeof(uint32) + path_length);
     }
 
     fclose(model_list);
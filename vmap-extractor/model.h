@@ -57,9 +57,10 @@ class Model
          * @brief
          *
          * @param outfilename
+         * @param nVertices receives the vertex count written to the file
          * @return bool
          */
-        bool ConvertToVMAPModel(std::string& outfilename, int iCoreNumber, const void *szRawVMAPMagic);
+        bool ConvertToVMAPModel(std::string& outfilename, uint32& nVertices, int iCoreNumber, const void *szRawVMAPMagic);
 
         bool ok; /**< TODO */
 
@@ -125,9 +126,9 @@ class ModelInstance
          * @param mapID
          * @param tileX
          * @param tileY
-         * @param pDirfile
+         * @param dirBuffer
          */
-        ModelInstance(MPQFile& f, std::string& ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile, int iCoreNumber);
+        ModelInstance(MPQFile& f, std::string const& ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<char>& dirBuffer, int iCoreNumber);
 
 };
 
@@ -135,11 +136,11 @@ class ModelInstance
  * @brief
  *
  * @param origPath original path of the model, cleaned with fixnamen and fixname2
- * @param fixedName will store the translated name (if changed)
+ * @param fixedName will point to the interned uniform name of the translated path
  * @param failedPaths Set to collect errors
  * @return bool
  */
-bool ExtractSingleModel(std::string& origPath, std::string& fixedName, std::set<std::string>& failedPaths, int iCoreNumber, const void *szRawVMAPMagic);
+bool ExtractSingleModel(std::string& origPath, std::string const*& fixedName, std::set<std::string>& failedPaths, int iCoreNumber, const void *szRawVMAPMagic);
 
 /**
  * @brief
@@ -0,0 +1,356 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "vertexkernels.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define VERTEX_KERNELS_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET(isa)
+#else
+#include <cpuid.h>
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+typedef void (*BoundsKernel)(float const*, size_t, float*, float*);    /**< TODO */
+typedef void (*WindingKernel)(uint16*, size_t);                         /**< TODO */
+
+/**
+ * @brief The kernels picked for this CPU
+ *
+ */
+struct VertexKernels
+{
+    BoundsKernel bounds;    /**< TODO */
+    WindingKernel winding;  /**< TODO */
+    char const* name;       /**< TODO */
+};
+
+static void GetVertexBoundsScalar(float const* vertices, size_t nVertices, float* lo, float* hi)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        lo[axis] = vertices[axis];
+        hi[axis] = vertices[axis];
+    }
+    for (size_t i = 1; i < nVertices; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float value = vertices[3 * i + axis];
+            if (value < lo[axis])
+            {
+                lo[axis] = value;
+            }
+            if (value > hi[axis])
+            {
+                hi[axis] = value;
+            }
+        }
+    }
+}
+
+static void SwapTriangleWindingScalar(uint16* indices, size_t nIndices)
+{
+    for (size_t i = 0; i + 2 < nIndices; i += 3)
+    {
+        uint16 tmp = indices[i + 1];
+        indices[i + 1] = indices[i + 2];
+        indices[i + 2] = tmp;
+    }
+}
+
+#ifdef VERTEX_KERNELS_X86
+
+/**
+ * @brief Gives a zero bound the sign the scalar loop ends on: that of the first zero
+ *
+ * @param vertices
+ * @param nVertices
+ * @param axis
+ * @param bound
+ */
+static void FixZeroBound(float const* vertices, size_t nVertices, int axis, float& bound)
+{
+    if (bound != 0.0f)
+    {
+        return;
+    }
+    for (size_t i = 0; i < nVertices; ++i)
+    {
+        if (vertices[3 * i + axis] == 0.0f)
+        {
+            bound = vertices[3 * i + axis];
+            return;
+        }
+    }
+}
+
+/**
+ * Four vertices fill three registers as x y z x | y z x y | z x y z, so
+ * each register keeps its own running minimum and maximum, which are folded
+ * per axis at the end.
+ *
+ * _mm_min_ps(a, b) returns b unless a < b, like the scalar compare: a NaN
+ * vertex is skipped and a NaN first vertex sticks. Only the sign of a zero
+ * can depend on the order of the compares; the scalar loop keeps the first
+ * zero of the array, so a zero result is taken from there.
+ */
+KERNEL_TARGET("sse2")
+static void GetVertexBoundsSSE2(float const* vertices, size_t nVertices, float* lo, float* hi)
+{
+    float const* first = vertices;
+    __m128 min0 = _mm_setr_ps(first[0], first[1], first[2], first[0]);
+    __m128 min1 = _mm_setr_ps(first[1], first[2], first[0], first[1]);
+    __m128 min2 = _mm_setr_ps(first[2], first[0], first[1], first[2]);
+    __m128 max0 = min0, max1 = min1, max2 = min2;
+
+    size_t i = 1;
+    for (; i + 4 <= nVertices; i += 4)
+    {
+        float const* p = vertices + 3 * i;
+        __m128 a = _mm_loadu_ps(p);
+        __m128 b = _mm_loadu_ps(p + 4);
+        __m128 c = _mm_loadu_ps(p + 8);
+        min0 = _mm_min_ps(a, min0);
+        min1 = _mm_min_ps(b, min1);
+        min2 = _mm_min_ps(c, min2);
+        max0 = _mm_max_ps(a, max0);
+        max1 = _mm_max_ps(b, max1);
+        max2 = _mm_max_ps(c, max2);
+    }
+
+    float lanesLo[12], lanesHi[12];
+    _mm_storeu_ps(lanesLo, min0);
+    _mm_storeu_ps(lanesLo + 4, min1);
+    _mm_storeu_ps(lanesLo + 8, min2);
+    _mm_storeu_ps(lanesHi, max0);
+    _mm_storeu_ps(lanesHi + 4, max1);
+    _mm_storeu_ps(lanesHi + 8, max2);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        lo[axis] = lanesLo[axis];
+        hi[axis] = lanesHi[axis];
+        for (int lane = axis + 3; lane < 12; lane += 3)
+        {
+            if (lanesLo[lane] < lo[axis])
+            {
+                lo[axis] = lanesLo[lane];
+            }
+            if (lanesHi[lane] > hi[axis])
+            {
+                hi[axis] = lanesHi[lane];
+            }
+        }
+    }
+
+    for (; i < nVertices; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float value = vertices[3 * i + axis];
+            if (value < lo[axis])
+            {
+                lo[axis] = value;
+            }
+            if (value > hi[axis])
+            {
+                hi[axis] = value;
+            }
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        FixZeroBound(vertices, nVertices, axis, lo[axis]);
+        FixZeroBound(vertices, nVertices, axis, hi[axis]);
+    }
+}
+
+/**
+ * Eight triangles fill three registers. Only the corners 7 and 8 of a block
+ * cross from one register to the next; the other swaps are a shuffle within
+ * a register.
+ */
+KERNEL_TARGET("ssse3")
+static void SwapTriangleWindingSSSE3(uint16* indices, size_t nIndices)
+{
+    __m128i const shuffle0 = _mm_setr_epi8(0, 1, 4, 5, 2, 3, 6, 7, 10, 11, 8, 9, 12, 13, 14, 15);
+    __m128i const shuffle1 = _mm_setr_epi8(0, 1, 2, 3, 6, 7, 4, 5, 8, 9, 12, 13, 10, 11, 14, 15);
+    __m128i const shuffle2 = _mm_setr_epi8(2, 3, 0, 1, 4, 5, 8, 9, 6, 7, 10, 11, 14, 15, 12, 13);
+
+    size_t i = 0;
+    for (; i + 24 <= nIndices; i += 24)
+    {
+        __m128i* p = reinterpret_cast<__m128i*>(indices + i);
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle0);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), shuffle1);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), shuffle2);
+        int corner7 = _mm_extract_epi16(a, 7);
+        int corner8 = _mm_extract_epi16(b, 0);
+        a = _mm_insert_epi16(a, corner8, 7);
+        b = _mm_insert_epi16(b, corner7, 0);
+        _mm_storeu_si128(p, a);
+        _mm_storeu_si128(p + 1, b);
+        _mm_storeu_si128(p + 2, c);
+    }
+    SwapTriangleWindingScalar(indices + i, nIndices - i);
+}
+
+/**
+ * @brief ECX and EDX of CPUID leaf 1
+ *
+ * @param ecx
+ * @param edx
+ * @return bool false if the leaf is not supported
+ */
+static bool GetCpuFeatures(uint32& ecx, uint32& edx)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 1)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    ecx = uint32(info[2]);
+    edx = uint32(info[3]);
+    return true;
+#else
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d))
+    {
+        return false;
+    }
+    ecx = c;
+    edx = d;
+    return true;
+#endif
+}
+
+#endif
+
+static VertexKernels SelectKernels()
+{
+    VertexKernels kernels = { &GetVertexBoundsScalar, &SwapTriangleWindingScalar, "scalar" };
+#ifdef VERTEX_KERNELS_X86
+    uint32 ecx = 0, edx = 0;
+    if (GetCpuFeatures(ecx, edx) && (edx & (1 << 26)))         // SSE2
+    {
+        kernels.bounds = &GetVertexBoundsSSE2;
+        kernels.name = "sse2";
+        if (ecx & (1 << 9))                                     // SSSE3
+        {
+            kernels.winding = &SwapTriangleWindingSSSE3;
+            kernels.name = "sse2+ssse3";
+        }
+    }
+#endif
+    return kernels;
+}
+
+static VertexKernels const& GetKernels()
+{
+    static VertexKernels const kernels = SelectKernels();
+    return kernels;
+}
+
+void GetVertexBounds(float const* vertices, size_t nVertices, float* lo, float* hi)
+{
+    GetKernels().bounds(vertices, nVertices, lo, hi);
+}
+
+void SwapTriangleWinding(uint16* indices, size_t nIndices)
+{
+    GetKernels().winding(indices, nIndices);
+}
+
+char const* GetVertexKernelName()
+{
+    return GetKernels().name;
+}
+
+/**
+ * @brief Milliseconds for a number of runs of a kernel
+ *
+ * @param run
+ * @param repeat
+ * @return double
+ */
+template<class Run>
+static double TimeKernel(Run run, int repeat)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i)
+    {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool BenchmarkVertexKernels()
+{
+    size_t const nVertices = 1 << 20;
+    int const repeat = 50;
+
+    // Model-sized coordinates with exact and negative zeros among them
+    std::vector<float> vertices(3 * nVertices);
+    std::vector<uint16> indices(3 * nVertices + 2);
+    uint32 seed = 12345;
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        vertices[i] = (seed >> 24) == 0 ? ((seed & 1) ? -0.0f : 0.0f) : float(int32(seed >> 8) - (1 << 23)) / 4096.0f;
+    }
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        indices[i] = uint16(seed >> 16);
+    }
+
+    printf(" Vertex kernels in use: %s\n", GetVertexKernelName());
+
+    float lo[3], hi[3], loScalar[3], hiScalar[3];
+    double scalarTime = TimeKernel([&]() { GetVertexBoundsScalar(&vertices[0], nVertices, loScalar, hiScalar); }, repeat);
+    double kernelTime = TimeKernel([&]() { GetVertexBounds(&vertices[0], nVertices, lo, hi); }, repeat);
+    bool boundsMatch = !memcmp(lo, loScalar, sizeof(lo)) && !memcmp(hi, hiScalar, sizeof(hi));
+    printf(" bounds:  %8.2f ms scalar, %8.2f ms selected, %s\n", scalarTime, kernelTime, boundsMatch ? "same result" : "RESULTS DIFFER");
+
+    std::vector<uint16> swapped(indices), swappedScalar(indices);
+    scalarTime = TimeKernel([&]() { SwapTriangleWindingScalar(&swappedScalar[0], swappedScalar.size()); }, repeat);
+    kernelTime = TimeKernel([&]() { SwapTriangleWinding(&swapped[0], swapped.size()); }, repeat);
+    bool windingMatch = swapped == swappedScalar;
+    printf(" winding: %8.2f ms scalar, %8.2f ms selected, %s\n", scalarTime, kernelTime, windingMatch ? "same result" : "RESULTS DIFFER");
+
+    return boundsMatch && windingMatch;
+}
@@ -0,0 +1,75 @@
+/**
+ * MaNGOS is a full featured server for World of Warcraft, supporting
+ * the following clients: 1.12.x, 2.4.3, 3.3.5a, 4.3.4a and 5.4.8
+ *
+ * Copyright (C) 2005-2026 MaNGOS <https://www.getmangos.eu>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * World of Warcraft, and all World of Warcraft or Warcraft art, images,
+ * and lore are copyrighted by Blizzard Entertainment, Inc.
+ */
+
+#ifndef VERTEXKERNELS_H
+#define VERTEXKERNELS_H
+
+#include <cstddef>
+#include <loadlib.h>
+
+/**
+ * Batch kernels over the vertex and index arrays of the model converters.
+ *
+ * Each kernel has a plain C++ version and, on x86, an SSE version picked at
+ * the first call from what the CPU supports. The SSE versions give the same
+ * bits as the plain ones, so the raw model files do not depend on the
+ * machine that wrote them.
+ */
+
+/**
+ * @brief Bounding box of an array of vertices
+ *
+ * Gives the same result as comparing the vertices one by one, in order,
+ * starting with the first.
+ *
+ * @param vertices x, y, z of each vertex
+ * @param nVertices at least 1
+ * @param lo receives the lowest x, y and z
+ * @param hi receives the highest x, y and z
+ */
+void GetVertexBounds(float const* vertices, size_t nVertices, float* lo, float* hi);
+
+/**
+ * @brief Reverses the winding of a triangle list by swapping the last two corners of each triangle
+ *
+ * @param indices three vertex indices per triangle
+ * @param nIndices a trailing partial triangle is left alone
+ */
+void SwapTriangleWinding(uint16* indices, size_t nIndices);
+
+/**
+ * @brief Name of the kernels in use, such as "sse2+ssse3" or "scalar"
+ *
+ * @return const char
+ */
+char const* GetVertexKernelName();
+
+/**
+ * @brief Times the selected kernels against the plain ones and checks they agree
+ *
+ * @return bool false if a kernel gave a different result
+ */
+bool BenchmarkVertexKernels();
+
+#endif
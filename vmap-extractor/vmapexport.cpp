@@ -29,9 +29,11 @@
 #include <algorithm>
 #include <errno.h>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 
 #if defined WIN32
@@ -39,8 +41,10 @@
 #include <sys/stat.h>
 #include <direct.h>
 #define mkdir _mkdir
+#define rmdir _rmdir
 #else
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <dirent.h>
 
@@ -62,12 +66,20 @@
 #include "adtfile.h"
 #include "wdtfile.h"
 #include "dbcfile.h"
+#include "DBCStructure.h"
 #include "wmo.h"
+#include "journal.h"
+#include "meshopt.h"
+#include "dedup.h"
+#include "vertexkernels.h"
 #include <mpq.h>
 #include "vmapexport.h"
 #include <openssl/evp.h>
 
 #include "ExtractorCommon.h"
+#include "ExtractorTelemetry.h"
+#include "ExtractorTrace.h"
+#include "WorkerPool.h"
 
 //------------------------------------------------------------------------------
 // Defines
@@ -85,7 +97,6 @@ typedef struct
 } map_id;
 
 map_id* map_ids;
-uint16* LiqType = 0;
 uint32 map_count;
 char output_path[128] = ".";
 char input_path[1024] = ".";
@@ -152,6 +163,11 @@ char const szWorkDirWmo[]   = "./Buildings";
 char       szRawVMAPMagic[] = "VMAP000";
 
 uint32 CONF_threads = 0;            ///< Worker threads for tile extraction; 0 = auto-detect cores, 1 = serial.
+bool CONF_keepRaw = false;          ///< Keep the raw model files in szWorkDirWmo after a successful assembly.
+bool CONF_resume = false;           ///< Continue an interrupted run from its journal.
+bool CONF_optimizeMesh = false;     ///< Weld and clean up the collision meshes of the raw model files.
+bool CONF_quantizeReport = false;   ///< Report the error an int16 grid in the bounding box would add to the vertices.
+bool CONF_dedupModels = false;      ///< Keep one copy of identical raw model files.
 
 // Serializes MPQ archive reads. StormLib mutates a shared per-archive file
 // position with no internal lock, so concurrent reads from one handle race
@@ -159,6 +175,42 @@ uint32 CONF_threads = 0;            ///< Worker threads for tile extraction; 0 =
 // parsing and geometry conversion that follow run in parallel.
 std::mutex g_mpqReadMutex;
 
+TelemetryCounter g_wmosConverted("wmos converted");
+TelemetryCounter g_wmoGroupsConverted("wmo groups converted");
+TelemetryCounter g_modelsConverted("models converted");
+TelemetryCounter g_modelsReused("models reused");
+TelemetryCounter g_placementsWritten("placements written");
+TelemetryCounter g_bytesWritten("bytes written", TELEMETRY_BYTES);
+TelemetryCounter g_mpqLockWait("mpq lock wait", TELEMETRY_TIME);
+TelemetryCounter g_extractWait("model extract wait", TELEMETRY_TIME);
+TelemetryCounter g_tileModelTime("tile model extraction", TELEMETRY_TIME);
+TelemetryCounter g_tilePlacementTime("tile placement writing", TELEMETRY_TIME);
+
+bool ExtractRegistry::claim(std::string const& name, std::promise<bool>& extracted, bool& result, char const* waitName)
+{
+    std::shared_future<bool> pending;
+    {
+        NameTableShard<std::shared_future<bool> >& shard = GetNameTableShard(m_extracts, name);
+        std::lock_guard<std::mutex> lock(shard.lock);
+        std::unordered_map<std::string, std::shared_future<bool> >::const_iterator itr = shard.values.find(name);
+        if (itr == shard.values.end())
+        {
+            shard.values[name] = extracted.get_future().share();
+            return true;
+        }
+        pending = itr->second;
+    }
+
+    if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        TraceScope wait(waitName);
+        TelemetryTimer waitTime(g_extractWait);
+        pending.wait();
+    }
+    result = pending.get();
+    return false;
+}
+
 // Local testing functions
 
 bool FileExists(const char* file)
@@ -171,20 +223,74 @@ bool FileExists(const char* file)
     return false;
 }
 
+/// Vertex counts of the extracted models by uniform name, so placements do
+/// not reopen the model file
+static NameTableShard<int> s_vertexCounts[NAME_TABLE_SHARDS];
+
+/// MD5 digests of the directory part of GetUniformName() paths
+static NameTableShard<std::string> s_dirDigests[NAME_TABLE_SHARDS];
+
+/// Uniform names by lowercased path, for GetInternedUniformName()
+static NameTableShard<std::string> s_uniformNames[NAME_TABLE_SHARDS];
+
+void SetModelVertexCount(std::string const& name, int nVertices)
+{
+    NameTableShard<int>& shard = GetNameTableShard(s_vertexCounts, name);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    shard.values[name] = nVertices;
+}
+
+int GetModelVertexCount(std::string const& name)
+{
+    NameTableShard<int>& shard = GetNameTableShard(s_vertexCounts, name);
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        std::unordered_map<std::string, int>::const_iterator itr = shard.values.find(name);
+        if (itr != shard.values.end())
+        {
+            return itr->second;
+        }
+    }
+
+    // Not extracted by this run: the file is left over from a previous one
+    int nVertices = -1;
+    std::string path = std::string(szWorkDirWmo) + "/" + name;
+    if (FILE* input = fopen(path.c_str(), "rb"))
+    {
+        fseek(input, 8, SEEK_SET);
+        if (fread(&nVertices, sizeof(int), 1, input) != 1)
+        {
+            nVertices = 0;
+        }
+        fclose(input);
+    }
+
+    SetModelVertexCount(name, nVertices);
+    return nVertices;
+}
+
 void compute_md5(const char* value, char* result)
 {
     // Hashes a path string into a stable uniform filename -- no security role.
     // Uses OpenSSL EVP rather than the 383-line vendored MD5 that used to live
     // in shared/Auth: the tree already links OpenSSL everywhere, so carrying a
     // second implementation of the same digest bought nothing.
+    // One context per thread, re-initialised for each digest instead of
+    // being allocated and freed every call.
+    struct DigestContext
+    {
+        DigestContext() : ctx(EVP_MD_CTX_new()) {}
+        ~DigestContext() { EVP_MD_CTX_free(ctx); }
+        EVP_MD_CTX* ctx;
+    };
+    static thread_local DigestContext context;
+
     unsigned char digest[EVP_MAX_MD_SIZE];
     unsigned int  length = 0;
 
-    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-    EVP_DigestInit_ex(ctx, EVP_md5(), NULL);
-    EVP_DigestUpdate(ctx, value, strlen(value));
-    EVP_DigestFinal_ex(ctx, digest, &length);
-    EVP_MD_CTX_free(ctx);
+    EVP_DigestInit_ex(context.ctx, EVP_md5(), NULL);
+    EVP_DigestUpdate(context.ctx, value, strlen(value));
+    EVP_DigestFinal_ex(context.ctx, digest, &length);
 
     for (unsigned int i = 0; i < length; ++i)
     {
@@ -199,7 +305,6 @@ std::string GetUniformName(std::string& path)
 
     string tempPath;
     string file;
-    char digest[33];
 
     std::size_t found = path.find_last_of("/\\");
     if (found != string::npos)
@@ -212,21 +317,60 @@ std::string GetUniformName(std::string& path)
         file = tempPath = path;
     }
 
-    if (!tempPath.empty())
+    if (tempPath.empty())
     {
-        compute_md5(tempPath.c_str(),digest);
+        tempPath = "\\";
     }
-    else
+
+    // A few hundred directories repeat across every ADT, so their digests
+    // are computed once and shared by all workers.
+    string result;
+    NameTableShard<std::string>& shard = GetNameTableShard(s_dirDigests, tempPath);
     {
-        compute_md5("\\",digest);
+        std::lock_guard<std::mutex> lock(shard.lock);
+        std::unordered_map<std::string, std::string>::const_iterator itr = shard.values.find(tempPath);
+        if (itr != shard.values.end())
+        {
+            result = itr->second;
+        }
     }
 
-    string result;
-    result = result.assign(digest) + "-" + file;
+    if (result.empty())
+    {
+        char digest[33];
+        compute_md5(tempPath.c_str(), digest);
+        result.assign(digest);
+
+        std::lock_guard<std::mutex> lock(shard.lock);
+        shard.values[tempPath] = result;
+    }
 
+    result += "-";
+    result += file;
     return result;
 }
 
+std::string const* GetInternedUniformName(std::string& path)
+{
+    std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+
+    NameTableShard<std::string>& shard = GetNameTableShard(s_uniformNames, path);
+    {
+        std::lock_guard<std::mutex> lock(shard.lock);
+        std::unordered_map<std::string, std::string>::const_iterator itr = shard.values.find(path);
+        if (itr != shard.values.end())
+        {
+            return &itr->second;
+        }
+    }
+
+    // Elements of an unordered_map keep their address through rehashes; a
+    // name interned by another thread meanwhile wins the insert.
+    std::string name = GetUniformName(path);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return &shard.values.insert(std::make_pair(path, name)).first->second;
+}
+
 std::string GetExtension(std::string& path)
 {
     string ext;
@@ -244,39 +388,20 @@ std::string GetExtension(std::string& path)
 }
 
 /**
- * @brief
+ * @brief One map of ParseMapFiles, from its WDT until its placements are in dir_bin
  *
  */
-void ReadLiquidTypeTableDBC()
+struct MapWork
 {
-    printf("\n Reading liquid types from LiquidType.dbc...");
-
-    HANDLE dbcFile;
-    if (!OpenNewestFile("DBFilesClient\\LiquidType.dbc", &dbcFile))
-    {
-        printf("Error: Cannot find LiquidType.dbc in archive!\n");
-        exit(1);
-    }
-
-    DBCFile dbc(dbcFile);
-    if (!dbc.open())
-    {
-        printf("Fatal error: Could not read LiquidType.dbc!\n");
-        exit(1);
-    }
-
-    size_t LiqType_count = dbc.getRecordCount();
-    size_t LiqType_maxid = dbc.getMaxId();
-    LiqType = new uint16[LiqType_maxid + 1];
-    memset(LiqType, 0xff, (LiqType_maxid + 1) * sizeof(uint16));
-
-    for (uint32 x = 0; x < LiqType_count; ++x)
-    {
-        LiqType[dbc.getRecord(x).getUInt(0)] = dbc.getRecord(x).getUInt(3);
-    }
-
-    printf(" Success! %zu liquid types loaded.\n", LiqType_count);
-}
+    MapWork(HANDLE handle, char* fn, char* name, uint32 mapId) : wdt(handle, fn, name), mapId(mapId), pendingTiles(0) {}
+
+    WDTFile wdt;                                    /**< TODO */
+    uint32 mapId;                                   /**< TODO */
+    std::vector<char> mapBuffer;                    ///< global WMO placements, then the merged tiles
+    std::vector<std::pair<int, int> > tiles;        ///< tiles with terrain, in x/y order
+    std::vector<std::vector<char> > tileBuffers;    ///< placement records of tiles[i]
+    uint32 pendingTiles;                            ///< tiles not yet parsed, guarded by the done mutex
+};
 
 void ParseMapFiles(int iCoreNumber)
 {
@@ -285,119 +410,162 @@ void ParseMapFiles(int iCoreNumber)
     char id[10];
     StringSet failedPaths;
     printf("\n");
+
+    // Tiles of all maps go to one pool, so the workers move on to the next
+    // map while the last tiles of the previous one are still being parsed.
+    // Maps are written to dir_bin strictly in map order as they complete.
+    WorkerPool pool(CONF_threads);
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    std::deque<MapWork*> maps;
+
+    auto flushMaps = [&](bool waitAll)
+    {
+        while (!maps.empty())
+        {
+            MapWork* work = maps.front();
+            {
+                std::unique_lock<std::mutex> lock(doneMutex);
+                if (work->pendingTiles && !waitAll)
+                {
+                    return;
+                }
+                doneCv.wait(lock, [work] { return work->pendingTiles == 0; });
+            }
+            maps.pop_front();
+
+            // Merge the tile buffers behind the WDT's global placements in
+            // tile order, so dir_bin comes out the same no matter which worker
+            // handled which tile, and append the map with a single write.
+            std::vector<char>& mapBuffer = work->mapBuffer;
+            size_t mapBytes = mapBuffer.size();
+            for (size_t t = 0; t < work->tileBuffers.size(); ++t)
+            {
+                mapBytes += work->tileBuffers[t].size();
+            }
+            mapBuffer.reserve(mapBytes);
+            for (size_t t = 0; t < work->tileBuffers.size(); ++t)
+            {
+                mapBuffer.insert(mapBuffer.end(), work->tileBuffers[t].begin(), work->tileBuffers[t].end());
+            }
+
+            std::string dirBin = std::string(szWorkDirWmo) + "/dir_bin";
+            if (FILE* dirfile = fopen(dirBin.c_str(), "ab"))
+            {
+                bool written = mapBuffer.empty() || fwrite(&mapBuffer[0], 1, mapBuffer.size(), dirfile) == mapBuffer.size();
+                fseek(dirfile, 0, SEEK_END);
+                uint64 dirBinSize = uint64(ftell(dirfile));
+                g_bytesWritten.add(mapBuffer.size());
+                if (fclose(dirfile) == 0 && written)
+                {
+                    journalMap(work->mapId, dirBinSize);
+                }
+            }
+            else
+            {
+                printf("Can't open dirfile!'%s'\n", dirBin.c_str());
+            }
+            delete work;
+        }
+    };
+
     for (unsigned int i = 0; i < map_count; ++i)
     {
         sprintf(id, "%04u", map_ids[i].id);
         sprintf(fn, "World\\Maps\\%s\\%s.wdt", map_ids[i].name, map_ids[i].name);
 
-        HANDLE handleWDT;
-        if (!OpenNewestFile(fn, &handleWDT))
+        if (isMapJournaled(map_ids[i].id))
         {
-            printf("Error opening WDT file %s\n", fn);
+            printf(" Map %u (%s) was completed by the interrupted run\n", map_ids[i].id, map_ids[i].name);
             continue;
         }
 
-        WDTFile WDT(handleWDT, fn, map_ids[i].name);
-        if (WDT.init(id, map_ids[i].id))
+        MapWork* work;
         {
-            printf(" Processing Map %u (%s)\n", map_ids[i].id, map_ids[i].name);
-
-            // Queue every tile slot; GetMap() returns NULL for absent ones.
-            std::queue<std::pair<int, int> > tileQueue;
-            for (int x = 0; x < 64; ++x)
+            // The workers are reading ADTs of earlier maps meanwhile
+            TracedLock mpqLock(g_mpqReadMutex, "mpq lock wait", &g_mpqLockWait);
+            HANDLE handleWDT;
+            if (!OpenNewestFile(fn, &handleWDT))
             {
-                for (int y = 0; y < 64; ++y)
-                {
-                    tileQueue.push(std::make_pair(x, y));
-                }
+                printf("Error opening WDT file %s\n", fn);
+                continue;
             }
+            work = new MapWork(handleWDT, fn, map_ids[i].name, map_ids[i].id);
+        }
 
-            uint32 nThreads = CONF_threads ? CONF_threads : std::thread::hardware_concurrency();
-            if (nThreads < 1)
-            {
-                nThreads = 1;
-            }
+        if (!work->wdt.init(id, map_ids[i].id, work->mapBuffer))
+        {
+            delete work;
+            continue;
+        }
+        printf(" Processing Map %u (%s)\n", map_ids[i].id, map_ids[i].name);
 
-            uint32 mapId = map_ids[i].id;
-            std::mutex queueMutex;
-            std::mutex failedMutex;
-            auto worker = [&]()
+        // Only the tiles the WDT flags as having an ADT
+        for (int x = 0; x < 64; ++x)
+        {
+            for (int y = 0; y < 64; ++y)
             {
-                StringSet localFailed;
-                while (true)
+                if (work->wdt.hasTerrain(y, x))
                 {
-                    int x, y;
-                    {
-                        std::lock_guard<std::mutex> lock(queueMutex);
-                        if (tileQueue.empty())
-                        {
-                            break;
-                        }
-                        x = tileQueue.front().first;
-                        y = tileQueue.front().second;
-                        tileQueue.pop();
-                    }
-                    if (ADTFile* ADT = WDT.GetMap(x, y))
-                    {
-                        ADT->init(mapId, x, y, localFailed, iCoreNumber, szRawVMAPMagic);
-                        delete ADT;
-                    }
+                    work->tiles.push_back(std::make_pair(x, y));
                 }
-                std::lock_guard<std::mutex> lock(failedMutex);
-                failedPaths.insert(localFailed.begin(), localFailed.end());
-            };
-
-            if (nThreads <= 1)
+            }
+        }
+        work->tileBuffers.resize(work->tiles.size());
+
+        // Tiles the interrupted run parsed keep their spooled placements
+        uint32 mapId = map_ids[i].id;
+        std::map<std::pair<int, int>, std::vector<char> > journaledTiles;
+        loadJournaledTiles(mapId, journaledTiles);
+        std::vector<size_t> pendingTiles;
+        for (size_t t = 0; t < work->tiles.size(); ++t)
+        {
+            std::map<std::pair<int, int>, std::vector<char> >::iterator done = journaledTiles.find(work->tiles[t]);
+            if (done != journaledTiles.end())
             {
-                // Serial path: one worker on this thread.
-                worker();
+                work->tileBuffers[t].swap(done->second);
             }
             else
             {
-                std::vector<std::thread> workers;
-                workers.reserve(nThreads);
-                for (uint32 t = 0; t < nThreads; ++t)
-                {
-                    workers.emplace_back(worker);
-                }
-                for (std::thread& w : workers)
-                {
-                    w.join();
-                }
+                pendingTiles.push_back(t);
             }
+        }
+        if (!journaledTiles.empty())
+        {
+            printf(" Resuming Map %u with %u of %u tiles done\n", mapId, uint32(work->tiles.size() - pendingTiles.size()), uint32(work->tiles.size()));
+        }
 
-            // Concatenate the per-tile temp files into dir_bin in tile order,
-            // so dir_bin is assembled in the same order no matter which worker
-            // wrote which tile, then remove the temps.
-            std::string dirBin = std::string(szWorkDirWmo) + "/dir_bin";
-            if (FILE* out = fopen(dirBin.c_str(), "ab"))
+        work->pendingTiles = uint32(pendingTiles.size());
+        maps.push_back(work);
+
+        for (size_t p = 0; p < pendingTiles.size(); ++p)
+        {
+            size_t t = pendingTiles[p];
+            pool.submit([&, work, mapId, t]()
             {
-                char copyBuf[8192];
-                for (int x = 0; x < 64; ++x)
+                int x = work->tiles[t].first;
+                int y = work->tiles[t].second;
+                StringSet localFailed;
+                if (ADTFile* ADT = work->wdt.GetMap(x, y))
                 {
-                    for (int y = 0; y < 64; ++y)
-                    {
-                        char tileSuffix[32];
-                        sprintf(tileSuffix, "/dir_bin.%u_%u", (uint32)x, (uint32)y);
-                        std::string tilePath = std::string(szWorkDirWmo) + tileSuffix;
-                        FILE* in = fopen(tilePath.c_str(), "rb");
-                        if (!in)
-                        {
-                            continue;
-                        }
-                        size_t n;
-                        while ((n = fread(copyBuf, 1, sizeof(copyBuf), in)) > 0)
-                        {
-                            fwrite(copyBuf, 1, n, out);
-                        }
-                        fclose(in);
-                        remove(tilePath.c_str());
-                    }
+                    TelemetryTile tile(mapId, x, y, pool.getPending());
+                    ADT->init(mapId, x, y, localFailed, work->tileBuffers[t], iCoreNumber, szRawVMAPMagic);
+                    delete ADT;
                 }
-                fclose(out);
-            }
+                journalTile(mapId, x, y, work->tileBuffers[t]);
+
+                std::lock_guard<std::mutex> lock(doneMutex);
+                failedPaths.insert(localFailed.begin(), localFailed.end());
+                if (--work->pendingTiles == 0)
+                {
+                    doneCv.notify_all();
+                }
+            });
         }
+
+        flushMaps(false);
     }
+    flushMaps(true);
 
     if (!failedPaths.empty())
     {
@@ -520,6 +688,113 @@ void AppendPatchMPQFilesToList(char const* subdir, char const* suffix, char cons
 #endif
 }
 
+void ListDirFiles(char const* dirname, std::vector<std::string>& files)
+{
+    files.clear();
+
+#ifdef WIN32
+
+    char maskname[512];
+    sprintf(maskname, "%s/*", dirname);
+
+    WIN32_FIND_DATA ffd;
+    HANDLE hFind = FindFirstFile(maskname, &ffd);
+
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if (!(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            {
+                files.push_back(ffd.cFileName);
+            }
+        } while (FindNextFile(hFind, &ffd) != 0);
+
+        FindClose(hFind);
+    }
+
+#else
+
+    if (DIR* dp = opendir(dirname))
+    {
+        dirent* dirp;
+        while ((dirp = readdir(dp)) != NULL)
+        {
+            if (strcmp(dirp->d_name, ".") && strcmp(dirp->d_name, ".."))
+            {
+                files.push_back(dirp->d_name);
+            }
+        }
+        closedir(dp);
+    }
+
+#endif
+}
+
+bool IsRawModelName(std::string const& name)
+{
+    return name.length() > 33 && name[32] == '-' && strspn(name.c_str(), "0123456789abcdef") == 32;
+}
+
+bool ReadWholeFile(std::string const& path, std::vector<char>& data)
+{
+    data.clear();
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in)
+    {
+        return false;
+    }
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), in)) > 0)
+    {
+        data.insert(data.end(), block, block + n);
+    }
+    fclose(in);
+    return true;
+}
+
+/**
+ * @brief Whether a file of the work directory is one the extractor writes for the assembly
+ *
+ * @param name file name without the directory
+ * @return bool
+ */
+static bool IsWorkFileName(std::string const& name)
+{
+    if (IsRawModelName(name) || name == "dir_bin" || name == "temp_gameobject_models" || name == "journal")
+    {
+        return true;
+    }
+    // Per-map tile journals, tiles_<map>.journal
+    return name.compare(0, 6, "tiles_") == 0 && name.length() > 14 && name.compare(name.length() - 8, 8, ".journal") == 0;
+}
+
+/**
+ * @brief Deletes the raw model files, dir_bin and the other intermediate files, then the directory
+ *
+ * Files the extractor did not write are left alone, and the directory is then
+ * kept as well.
+ *
+ * @param dirname
+ */
+void RemoveWorkDir(char const* dirname)
+{
+    std::vector<std::string> files;
+    ListDirFiles(dirname, files);
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (IsWorkFileName(files[i]))
+        {
+            remove((std::string(dirname) + "/" + files[i]).c_str());
+        }
+    }
+    if (rmdir(dirname) != 0)
+    {
+        printf(" Could not remove %s, it is not empty\n", dirname);
+    }
+}
+
 void LoadLocaleMPQFiles(int const locale)
 {
     char filename[512];
@@ -696,6 +971,20 @@ void Usage(char* prg)
     printf("                         size by ~ 500MB\n");
     printf("   -t, --threads #       worker threads for tile extraction. 0 = auto-detect\n");
     printf("                         cores (default), 1 = serial.\n");
+    printf("   -k, --keep-raw        keep the raw model files in %s after the vmaps\n", szWorkDirWmo);
+    printf("                         are built, for debugging.\n");
+    printf("   -r, --resume          continue an interrupted extraction from its journal\n");
+    printf("                         instead of starting over.\n");
+    printf("   -o, --optimize-mesh   weld collision mesh vertices and drop degenerate\n");
+    printf("                         and duplicate triangles.\n");
+    printf("   -q, --quantize-report report how far an int16 grid inside the bounding\n");
+    printf("                         box would move model vertices; output unchanged.\n");
+    printf("   -u, --dedup           keep one copy of identical model files and point\n");
+    printf("                         the placements at it.\n");
+    printf("   --bench-kernels       time the vertex kernels of this CPU against the\n");
+    printf("                         plain ones, then exit.\n");
+    printTelemetryUsage();
+    printTraceUsage();
     printf("\n");
     printf(" Example:\n");
     printf(" - use data path and create larger vmaps:\n");
@@ -742,6 +1031,42 @@ bool processArgv(int argc, char** argv)
             result = true;
             CONF_threads = atoi(param);
         }
+        else if (strcmp(argv[i], "-k") == 0 || strcmp(argv[i], "--keep-raw") == 0 )
+        {
+            result = true;
+            CONF_keepRaw = true;
+        }
+        else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--resume") == 0 )
+        {
+            result = true;
+            CONF_resume = true;
+        }
+        else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--optimize-mesh") == 0 )
+        {
+            result = true;
+            CONF_optimizeMesh = true;
+        }
+        else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quantize-report") == 0 )
+        {
+            result = true;
+            CONF_quantizeReport = true;
+        }
+        else if (strcmp(argv[i], "--bench-kernels") == 0 )
+        {
+            exit(BenchmarkVertexKernels() ? 0 : 1);
+        }
+        else if (strcmp(argv[i], "-u") == 0 || strcmp(argv[i], "--dedup") == 0 )
+        {
+            result = true;
+            CONF_dedupModels = true;
+        }
+        else if (handleTelemetryArgs(argc, argv, i, result) || handleTraceArgs(argc, argv, i, result))
+        {
+            if (!result)
+            {
+                break;
+            }
+        }
         else
         {
             result = false;
@@ -787,15 +1112,17 @@ int main(int argc, char** argv)
     struct stat status;
     bool dirty = false;
 
-    if (!stat(sdir.c_str(), &status) || !stat(sdir_bin.c_str(), &status))
+    // A resumed run picks up the work directory as its journal left it; the
+    // vmaps are assembled from scratch at the end either way.
+    if (!CONF_resume && (!stat(sdir.c_str(), &status) || !stat(sdir_bin.c_str(), &status)))
     {
-        printf(" Your %s directory seems to exist, please delete it!\n", szWorkDirWmo);
+        printf(" Your %s directory seems to exist, please delete it or continue with --resume!\n", szWorkDirWmo);
         dirty = true;
     }
 
-    if (!stat(outDir.c_str(), &status))
+    if (!CONF_resume && !stat(outDir.c_str(), &status))
     {
-        printf(" Your %s directory seems to exist, please delete it!\n", outDir.c_str());
+        printf(" Your %s directory seems to exist, please delete it or continue with --resume!\n", outDir.c_str());
         dirty = true;
     }
 
@@ -808,10 +1135,16 @@ int main(int argc, char** argv)
     }
 
     printf(" Beginning work ....\n");
+    initTelemetry("vmap-extractor");
+    initTrace();
     //xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
     // Create the working and ouput directories
     CreateDir(std::string(szWorkDirWmo));
     CreateDir(outDir);
+    if (!openJournal(CONF_resume))
+    {
+        return 1;
+    }
 
     // prepare archive name list
     LoadCommonMPQFiles(iCoreNumber);
@@ -821,14 +1154,11 @@ int main(int argc, char** argv)
         printf("FATAL ERROR: None MPQ archive found by path '%s'. Use -d option with proper path.\n", input_path);
         return 1;
     }
-    if (iCoreNumber == CLIENT_CLASSIC)
-    {
-        ReadLiquidTypeTableDBC();
-    }
 
     // extract data
     if (success)
     {
+        TelemetryPhase phase("wmo");
         success = ExtractWmo(iCoreNumber, szRawVMAPMagic);
     }
 
@@ -852,24 +1182,48 @@ int main(int argc, char** argv)
             exit(1);
         }
 
-        map_count = dbc.getRecordCount();
+        DBCTable<MapEntry> maps(dbc);
+        if (!maps.isValid())
+        {
+            printf("Fatal error: Unexpected record size in Map.dbc!\n");
+            exit(1);
+        }
+
+        map_count = maps.size();
         map_ids = new map_id[map_count];
         for (unsigned int x = 0; x < map_count; ++x)
         {
-            map_ids[x].id = dbc.getRecord(x).getUInt(0);
-            strcpy(map_ids[x].name, dbc.getRecord(x).getString(1));
+            map_ids[x].id = maps[x].ID;
+            strcpy(map_ids[x].name, maps.getString(maps[x].InternalName));
             printf(" Map %d - %s\n", map_ids[x].id, map_ids[x].name);
         }
 
-        ParseMapFiles(iCoreNumber);
+        {
+            TelemetryPhase phase("tiles");
+            ParseMapFiles(iCoreNumber);
+        }
         delete [] map_ids;
         //nError = ERROR_SUCCESS;
         // Extract models, listed in DameObjectDisplayInfo.dbc
-        ExtractGameobjectModels(iCoreNumber, szRawVMAPMagic);
+        {
+            TelemetryPhase phase("gameobjects");
+            ExtractGameobjectModels(iCoreNumber, szRawVMAPMagic);
+        }
+        if (CONF_optimizeMesh)
+        {
+            printMeshOptimizationSummary();
+        }
+        if (CONF_quantizeReport)
+        {
+            printQuantizationSummary();
+        }
+        if (CONF_dedupModels)
+        {
+            TelemetryPhase phase("dedup");
+            success = DeduplicateModels(CONF_threads);
+        }
     }
 
-    delete [] LiqType;
-
     if (!success)
     {
         printf("ERROR: Extract for %s. Work NOT complete.\n   Precise vector data=%d.\nPress any key.\n", szRawVMAPMagic, preciseVectorData);
@@ -877,7 +1231,22 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    success = AssembleVMAP(std::string(szWorkDirWmo), outDir, szRawVMAPMagic, CONF_threads);
+    {
+        TelemetryPhase phase("assemble");
+        success = AssembleVMAP(std::string(szWorkDirWmo), outDir, szRawVMAPMagic, CONF_threads);
+    }
+
+    closeJournal();
+
+    // The raw files only feed the assembler; on failure they stay for a look
+    if (success && !CONF_keepRaw)
+    {
+        TelemetryPhase phase("cleanup");
+        printf(" Removing the raw model files in %s\n", szWorkDirWmo);
+        RemoveWorkDir(szWorkDirWmo);
+    }
+    shutdownTelemetry();
+    writeTrace();
 
     if (!success)
     {
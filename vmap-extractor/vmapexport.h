@@ -25,9 +25,15 @@
 #ifndef VMAPEXPORT_H
 #define VMAPEXPORT_H
 
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <set>
 #include <mutex>
+#include <future>
+#include <unordered_map>
+#include <vector>
+#include <ExtractorTelemetry.h>
 
 /**
  * @brief
@@ -54,6 +60,96 @@ extern char const szWorkDirWmo[]; /**< TODO */
 /// OpenNewestFile + MPQFile read; defined in vmapexport.cpp.
 extern std::mutex g_mpqReadMutex;
 
+// Totals for the telemetry summary; defined in vmapexport.cpp.
+extern TelemetryCounter g_wmosConverted;       ///< root WMOs written
+extern TelemetryCounter g_wmoGroupsConverted;  ///< WMO groups written
+extern TelemetryCounter g_modelsConverted;     ///< M2 models written
+extern TelemetryCounter g_modelsReused;        ///< model requests served by an earlier extraction
+extern TelemetryCounter g_placementsWritten;   ///< model and WMO placements in dir_bin
+extern TelemetryCounter g_bytesWritten;        ///< raw model files, dir_bin and the gameobject list
+extern TelemetryCounter g_mpqLockWait;         ///< waiting for g_mpqReadMutex
+extern TelemetryCounter g_extractWait;         ///< waiting for another thread to extract a model or WMO
+extern TelemetryCounter g_tileModelTime;       ///< extracting the models of tiles
+extern TelemetryCounter g_tilePlacementTime;   ///< writing the placements of tiles
+
+#define NAME_TABLE_SHARDS 16 ///< shards of the tables keyed by file name
+
+/**
+ * @brief One shard of a table keyed by file name that every worker hits
+ *
+ * The tables are split by name hash so the workers do not queue on a single lock.
+ */
+template<class Value>
+struct NameTableShard
+{
+    std::mutex lock;                                ///< guards values
+    std::unordered_map<std::string, Value> values;  /**< TODO */
+};
+
+/**
+ * @brief Shard of a NAME_TABLE_SHARDS sized table that holds name
+ *
+ * @param shards
+ * @param name
+ * @return NameTableShard<Value>
+ */
+template<class Value>
+inline NameTableShard<Value>& GetNameTableShard(NameTableShard<Value>* shards, std::string const& name)
+{
+    return shards[std::hash<std::string>()(name) % NAME_TABLE_SHARDS];
+}
+
+/**
+ * @brief Dedups model extraction across parallel workers
+ *
+ * Exactly one worker extracts a given model; the others wait on that model's
+ * future alone, until its file is on disk for the placement that follows.
+ */
+class ExtractRegistry
+{
+    public:
+        /**
+         * @brief Claim name for extraction, or wait for the worker that claimed it
+         *
+         * @param name uniform name of the model
+         * @param extracted set by the caller once it has extracted a claimed model
+         * @param result outcome of the earlier extraction, if not claimed
+         * @param waitName trace span for the time spent waiting
+         * @return bool true if the caller must extract the model and set extracted
+         */
+        bool claim(std::string const& name, std::promise<bool>& extracted, bool& result, char const* waitName);
+
+    private:
+        NameTableShard<std::shared_future<bool> > m_extracts[NAME_TABLE_SHARDS]; /**< TODO */
+};
+
+/**
+ * @brief Names of the files in a directory, without subdirectories
+ *
+ * @param dirname
+ * @param files
+ */
+void ListDirFiles(char const* dirname, std::vector<std::string>& files);
+
+/**
+ * @brief Test if a file in the building directory is a raw model or WMO file
+ *
+ * Raw files carry uniform names: <md5 of the directory>-<file name>
+ *
+ * @param name
+ * @return bool
+ */
+bool IsRawModelName(std::string const& name);
+
+/**
+ * @brief Reads a whole file
+ *
+ * @param path
+ * @param data receives the contents
+ * @return bool false if the file cannot be opened
+ */
+bool ReadWholeFile(std::string const& path, std::vector<char>& data);
+
 /**
  * @brief Test if the specified file exists in the building directory
  *
@@ -62,6 +158,25 @@ extern std::mutex g_mpqReadMutex;
  */
 bool FileExists(const char* file);
 
+/**
+ * @brief Record the vertex count of a model just written to the building directory
+ *
+ * @param name uniform name of the model file
+ * @param nVertices vertex count, or -1 if no file was written
+ */
+void SetModelVertexCount(std::string const& name, int nVertices);
+
+/**
+ * @brief Vertex count of an extracted model, as stored at offset 8 of its file
+ *
+ * Served from memory once the model is known; models extracted by an earlier
+ * run are read from the building directory once and then remembered.
+ *
+ * @param name uniform name of the model file
+ * @return int vertex count, or -1 if the model file does not exist
+ */
+int GetModelVertexCount(std::string const& name);
+
 /**
  * @brief Get "uniform" name for a path (a uniform name has the format <md5hash>-<filename>.<ext>)
  *
@@ -70,6 +185,74 @@ bool FileExists(const char* file);
  */
 std::string GetUniformName(std::string& path);
 
+/**
+ * @brief GetUniformName() of a path, kept for the whole run
+ *
+ * Paths repeat on every tile, so after the first time this is a lookup that
+ * does not allocate.
+ *
+ * @param path lowercased in place, as by GetUniformName()
+ * @return std::string const* stays valid until exit
+ */
+std::string const* GetInternedUniformName(std::string& path);
+
+/**
+ * @brief Uniform names of a MMDX/MWMO chunk, indexed by the placement records
+ *
+ */
+typedef std::vector<std::string const*> ChunkNames;
+
+/**
+ * @brief Name of a placement record, empty if its index is out of range
+ *
+ * @param names
+ * @param id
+ * @return std::string const&
+ */
+inline std::string const& GetChunkName(ChunkNames const& names, uint32_t id)
+{
+    static const std::string noName;
+    return id < names.size() ? *names[id] : noName;
+}
+
+/**
+ * @brief Number of names in a chunk of NUL terminated names, such as MMDX or MWMO
+ *
+ * @param p
+ * @param end
+ * @return size_t
+ */
+inline size_t CountChunkNames(char const* p, char const* end)
+{
+    size_t count = 0;
+    for (; p < end; ++count)
+    {
+        char const* nul = static_cast<char const*>(memchr(p, 0, end - p));
+        p = nul ? nul + 1 : end;
+    }
+    return count;
+}
+
+/**
+ * @brief Copies the next name of such a chunk into name, reusing its storage
+ *
+ * @param p advanced past the name
+ * @param end
+ * @param name
+ * @return bool false at the end of the chunk
+ */
+inline bool NextChunkName(char const*& p, char const* end, std::string& name)
+{
+    if (p >= end)
+    {
+        return false;
+    }
+    char const* nul = static_cast<char const*>(memchr(p, 0, end - p));
+    name.assign(p, nul ? nul : end);
+    p = nul ? nul + 1 : end;
+    return true;
+}
+
 /**
  * @brief Get extension for a file
  *
@@ -22,6 +22,7 @@
  * and lore are copyrighted by Blizzard Entertainment, Inc.
  */
 
+#include <algorithm>
 #include <cstdio>
 #include "vmapexport.h"
 #include "wdtfile.h"
@@ -29,16 +30,13 @@
 WDTFile::WDTFile(HANDLE handle, char* file_name, char* file_name1): WDT(handle, file_name)
 {
     filename.assign(file_name1);
-    // Initialize so the destructor's delete[] is safe for WDTs with no MWMO chunk.
-    gWmoInstansName = NULL;
-
     for (int i = 0; i < MAP_TILE_SIZE * MAP_TILE_SIZE; i++)
     {
         mapAreaInfo[i] = NULL;
     }
 }
 
-bool WDTFile::init(char* map_id, unsigned int mapID)
+bool WDTFile::init(char* map_id, unsigned int mapID, std::vector<char>& dirBuffer)
 {
     if (WDT.isEof())
     {
@@ -49,15 +47,6 @@ bool WDTFile::init(char* map_id, unsigned int mapID)
     char fourcc[5];
     uint32 size;
 
-    std::string dirname = std::string(szWorkDirWmo) + "/dir_bin";
-    FILE* dirfile;
-    dirfile = fopen(dirname.c_str(), "ab");
-    if (!dirfile)
-    {
-        printf("Can't open dirfile!'%s'\n", dirname.c_str());
-        return false;
-    }
-
     while (!WDT.isEof())
     {
         WDT.read(fourcc, 4);
@@ -90,18 +79,15 @@ bool WDTFile::init(char* map_id, unsigned int mapID)
             // global map objects
             if (size)
             {
-                char* buf = new char[size];
-                WDT.read(buf, size);
-                char* p = buf;
-                int q = 0;
-                gWmoInstansName = new string[size];
-                while (p < buf + size)
+                char const* p = WDT.getPointer();
+                char const* end = p + std::min<size_t>(size, WDT.getSize() - WDT.getPos());
+                std::string path;
+                gWmoInstansName.clear();
+                gWmoInstansName.reserve(CountChunkNames(p, end));
+                while (NextChunkName(p, end, path))
                 {
-                    string path(p);
-                    gWmoInstansName[q++] = GetUniformName(path);
-                    p = p + strlen(p) + 1;
+                    gWmoInstansName.push_back(GetInternedUniformName(path));
                 }
-                delete[] buf;
             }
         }
         else if (!strcmp(fourcc, "MODF"))
@@ -119,17 +105,13 @@ bool WDTFile::init(char* map_id, unsigned int mapID)
                 {
                     int id;
                     WDT.read(&id, 4);
-                    WMOInstance inst(WDT, gWmoInstansName[id], mapID, 65, 65, dirfile);
+                    WMOInstance inst(WDT, GetChunkName(gWmoInstansName, id), mapID, 65, 65, dirBuffer);
                 }
-                delete[] gWmoInstansName;
-                // Null after free so the destructor's delete[] cannot double-free.
-                gWmoInstansName = NULL;
             }
         }
         WDT.seek((int)nextpos);
     }
 
-    fclose(dirfile);
     return true;
 }
 
@@ -140,13 +122,13 @@ WDTFile::~WDTFile(void)
     {
         delete mapAreaInfo[i];
     }
-    delete [] gWmoInstansName;
-    gWmoInstansName = NULL;
 }
 
 bool WDTFile::hasTerrain(int x, int y)
 {
-    return (mapAreaInfo[x * MAP_TILE_SIZE + y]->flags & TERRAIN_HAS_ADT);
+    // NULL when the WDT had no MAIN chunk
+    SMAreaInfo const* info = mapAreaInfo[x * MAP_TILE_SIZE + y];
+    return info && (info->flags & TERRAIN_HAS_ADT);
 }
 
 ADTFile* WDTFile::GetMap(int x, int y)
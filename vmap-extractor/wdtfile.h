@@ -66,13 +66,14 @@ class WDTFile
          *
          * @param map_id
          * @param mapID
+         * @param dirBuffer receives the map's global WMO placement records
          * @return bool
          */
-        bool init(char* map_id, unsigned int mapID);
+        bool init(char* map_id, unsigned int mapID, std::vector<char>& dirBuffer);
 
         bool hasTerrain(int x, int y);
 
-        std::string* gWmoInstansName; /**< TODO */
+        ChunkNames gWmoInstansName; /**< TODO */
         int gnWMO, nMaps; /**< TODO */
 
         /**
@@ -24,19 +24,58 @@
 
 #include "vmapexport.h"
 #include "wmo.h"
+#include "journal.h"
+#include "meshopt.h"
 #include "vec3d.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cassert>
 #include <map>
 #include <fstream>
+#include <mutex>
+#include <vector>
 #include <ExtractorCommon.h>
+#include <ExtractorTrace.h>
+#include <WorkerPool.h>
 #undef min
 #undef max
 
-extern uint16* LiqType;
 extern bool preciseVectorData;
 extern ArchiveSet gOpenArchives;
+extern uint32 CONF_threads;
+extern bool CONF_optimizeMesh;
+extern bool CONF_quantizeReport;
+
+/// Output buffer of the WMO files written by this thread
+static thread_local std::vector<char> t_writeBuffer;
+
+// Dedup WMO extraction across parallel workers, the same way model.cpp does
+// for M2s: one worker converts a given root, the others wait until its file
+// is on disk.
+static ExtractRegistry s_wmoExtracts;
+
+/// Groups of one root WMO being converted. Each group is a pool task that
+/// converts into its own buffer; the root then writes the buffers in group
+/// order.
+struct WmoGroupJob
+{
+    WmoGroupJob(std::string const& base, WMORoot* root, int core, uint32 count)
+        : baseName(base), rootWMO(root), iCoreNumber(core), groups(count) {}
+
+    /// One converted group
+    struct Group
+    {
+        Group() : nVertices(0), ok(false) {}
+        std::vector<char> data;
+        int nVertices;
+        bool ok;
+    };
+
+    std::string baseName;           ///< root file name without ".wmo"
+    WMORoot* rootWMO;
+    int iCoreNumber;
+    std::vector<Group> groups;
+};
 
 WMORoot::WMORoot(std::string& filename) : filename(filename)
 {
@@ -44,12 +83,16 @@ WMORoot::WMORoot(std::string& filename) : filename(filename)
 
 bool WMORoot::open()
 {
+    TraceScope trace("wmo root read");
+    TracedLock mpqLock(g_mpqReadMutex, "mpq lock wait", &g_mpqLockWait);
     HANDLE mpqFile;
     if (!OpenNewestFile(filename.c_str(), &mpqFile))
     {
         printf("Error opening WMO Root %s\n", filename.c_str());
+        return false;
     }
     MPQFile f(mpqFile, filename.c_str());
+    mpqLock.unlock();
     if (f.isEof())
     {
         printf(" No such file %s.\n", filename.c_str());
@@ -132,15 +175,15 @@ bool WMORoot::open()
     return true;
 }
 
-bool WMORoot::ConvertToVMAPRootWmo(FILE* pOutfile, const void *szRawVMAPMagic)
+bool WMORoot::ConvertToVMAPRootWmo(BinaryWriter& out, const void *szRawVMAPMagic)
 {
     //printf("Convert RootWmo...\n");
 
-    fwrite(szRawVMAPMagic, 1, 8, pOutfile);
+    out.putBytes(szRawVMAPMagic, 8);
     unsigned int nVectors = 0;
-    fwrite(&nVectors, sizeof(nVectors), 1, pOutfile); // will be filled later
-    fwrite(&nGroups, 4, 1, pOutfile);
-    fwrite(&RootWMOID, 4, 1, pOutfile);
+    out.put(nVectors); // will be filled later
+    out.put(nGroups);
+    out.put(RootWMOID);
     return true;
 }
 
@@ -155,14 +198,18 @@ WMOGroup::WMOGroup(std::string& filename) : filename(filename),
 
 bool WMOGroup::open()
 {
+    TraceScope trace("wmo group read");
+    TracedLock mpqLock(g_mpqReadMutex, "mpq lock wait", &g_mpqLockWait);
     HANDLE mpqHandle;
 
     if (!OpenNewestFile(filename.c_str(), &mpqHandle))
     {
         printf("Error opening WMOGroup %s\n", filename.c_str());
+        return false;
     }
 
     MPQFile f(mpqHandle, filename.c_str());
+    mpqLock.unlock();
     if (f.isEof())
     {
         printf(" No such file.\n");
@@ -260,19 +307,24 @@ bool WMOGroup::open()
     return true;
 }
 
-int WMOGroup::ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPreciseVectorData, int iCoreNumber)
+int WMOGroup::ConvertToVMAPGroupWmo(std::vector<char>& output, WMORoot* rootWMO, bool pPreciseVectorData, int iCoreNumber)
 {
-    fwrite(&mogpFlags, sizeof(uint32), 1, output);
-    fwrite(&groupWMOID, sizeof(uint32), 1, output);
+    if (CONF_quantizeReport)
+    {
+        MeasureQuantizationError(MOVT, nVertices, bbcorn1, bbcorn2);
+    }
+
+    BinaryWriter out(output);
+    out.put(mogpFlags);
+    out.put(groupWMOID);
     // group bound
-    fwrite(bbcorn1, sizeof(float), 3, output);
-    fwrite(bbcorn2, sizeof(float), 3, output);
-    fwrite(&liquflags, sizeof(uint32), 1, output);
+    out.putSpan(bbcorn1, 3);
+    out.putSpan(bbcorn2, 3);
+    out.put(liquflags);
     int nColTriangles = 0;
     if (pPreciseVectorData)
     {
-        char GRP[] = "GRP ";
-        fwrite(GRP, 1, 4, output);
+        out.putTag("GRP ");
 
         int k = 0;
         int moba_batch = moba_size / 12;
@@ -282,69 +334,36 @@ int WMOGroup::ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPrecis
             MobaEx[k++] = MOBA[i];
         }
         int moba_size_grp = moba_batch * 4 + 4;
-        fwrite(&moba_size_grp, 4, 1, output);
-        fwrite(&moba_batch, 4, 1, output);
-        fwrite(MobaEx, 4, k, output);
+        out.put(moba_size_grp);
+        out.put(moba_batch);
+        out.putSpan(MobaEx, k);
         delete [] MobaEx;
 
         uint32 nIdexes = nTriangles * 3;
 
-        if (fwrite("INDX", 4, 1, output) != 1)
-        {
-            printf("Error while writing file nbraches ID");
-            exit(0);
-        }
+        out.putTag("INDX");
         int wsize = sizeof(uint32) + sizeof(unsigned short) * nIdexes;
-        if (fwrite(&wsize, sizeof(int), 1, output) != 1)
-        {
-            printf("Error while writing file wsize");
-            exit(0);
-        }
-        if (fwrite(&nIdexes, sizeof(uint32), 1, output) != 1)
-        {
-            printf("Error while writing file nIndexes");
-            exit(0);
-        }
+        out.put(wsize);
+        out.put(nIdexes);
         if (nIdexes > 0)
         {
-            if (fwrite(MOVI, sizeof(unsigned short), nIdexes, output) != nIdexes)
-            {
-                printf("Error while writing file indexarray");
-                exit(0);
-            }
+            out.putSpan(MOVI, nIdexes);
         }
 
-        if (fwrite("VERT", 4, 1, output) != 1)
-        {
-            printf("Error while writing file nbraches ID");
-            exit(0);
-        }
+        out.putTag("VERT");
         wsize = sizeof(int) + sizeof(float) * 3 * nVertices;
-        if (fwrite(&wsize, sizeof(int), 1, output) != 1)
-        {
-            printf("Error while writing file wsize");
-            exit(0);
-        }
-        if (fwrite(&nVertices, sizeof(int), 1, output) != 1)
-        {
-            printf("Error while writing file nVertices");
-            exit(0);
-        }
+        out.put(wsize);
+        out.put(nVertices);
         if (nVertices > 0)
         {
-            if (fwrite(MOVT, sizeof(float) * 3, nVertices, output) != nVertices)
-            {
-                printf("Error while writing file vectors");
-                exit(0);
-            }
+            out.putSpan(MOVT, 3 * nVertices);
         }
 
         nColTriangles = nTriangles;
     }
     else
     {
-        char GRP[] = "GRP ";
-        fwrite(GRP, 1, 4, output);
+        out.putTag("GRP ");
         int k = 0;
         int moba_batch = moba_size / 12;
         MobaEx = new int[moba_batch * 4];
@@ -354,9 +373,9 @@ int WMOGroup::ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPrecis
         }
 
         int moba_size_grp = moba_batch * 4 + 4;
-        fwrite(&moba_size_grp, 4, 1, output);
-        fwrite(&moba_batch, 4, 1, output);
-        fwrite(MobaEx, 4, k, output);
+        out.put(moba_size_grp);
+        out.put(moba_batch);
+        out.putSpan(MobaEx, k);
         delete [] MobaEx;
 
         //-------INDX------------------------------------
@@ -399,24 +418,62 @@ int WMOGroup::ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPrecis
             MoviEx[i] = IndexRenum[MoviEx[i]];
         }
 
-        // write triangle indices
-        int INDX[] = {0x58444E49, nColTriangles * 6 + 4, nColTriangles * 3};
-        fwrite(INDX, 4, 3, output);
-        fwrite(MoviEx, 2, nColTriangles * 3, output);
-
-        // write vertices
-        int VERT[] = {0x54524556, static_cast<int>(nColVertices * 3 * sizeof(float) + 4), nColVertices}; // "VERT"
-        int check = 3 * nColVertices;
-        fwrite(VERT, 4, 3, output);
-        for (uint32 i = 0; i < nVertices; ++i)
+        // welded copies of the collision triangles and vertices replace them
+        if (CONF_optimizeMesh && nColTriangles > 0)
         {
-            if (IndexRenum[i] >= 0)
+            std::vector<float> colVertices;
+            colVertices.reserve(3 * nColVertices);
+            for (uint32 i = 0; i < nVertices; ++i)
             {
-                check -= fwrite(MOVT + 3 * i, sizeof(float), 3, output);
+                if (IndexRenum[i] >= 0)
+                {
+                    colVertices.insert(colVertices.end(), MOVT + 3 * i, MOVT + 3 * i + 3);
+                }
             }
+            std::vector<uint16> colIndices(MoviEx, MoviEx + 3 * nColTriangles);
+            OptimizeCollisionMesh(colVertices, colIndices);
+            nColTriangles = int(colIndices.size() / 3);
+            nColVertices = int(colVertices.size() / 3);
+
+            int INDX[] = {0x58444E49, nColTriangles * 6 + 4, nColTriangles * 3};
+            out.putSpan(INDX, 3);
+            out.putSpan(colIndices.data(), colIndices.size());
+
+            int VERT[] = {0x54524556, static_cast<int>(nColVertices * 3 * sizeof(float) + 4), nColVertices}; // "VERT"
+            out.putSpan(VERT, 3);
+            out.putSpan(colVertices.data(), colVertices.size());
         }
+        else
+        {
+            // write triangle indices
+            int INDX[] = {0x58444E49, nColTriangles * 6 + 4, nColTriangles * 3};
+            out.putSpan(INDX, 3);
+            out.putSpan(MoviEx, nColTriangles * 3);
+
+            // write vertices
+            int VERT[] = {0x54524556, static_cast<int>(nColVertices * 3 * sizeof(float) + 4), nColVertices}; // "VERT"
+            int check = 3 * nColVertices;
+            out.putSpan(VERT, 3);
+            // Kept vertices come in runs, each written in one go
+            for (uint32 i = 0; i < nVertices;)
+            {
+                if (IndexRenum[i] < 0)
+                {
+                    ++i;
+                    continue;
+                }
+                uint32 run = i;
+                while (run < nVertices && IndexRenum[run] >= 0)
+                {
+                    ++run;
+                }
+                out.putSpan(MOVT + 3 * i, 3 * (run - i));
+                check -= 3 * (run - i);
+                i = run;
+            }
 
-        assert(check == 0);
+            assert(check == 0);
+        }
 
         delete [] MoviEx;
         delete [] IndexRenum;
@@ -426,7 +483,7 @@ int WMOGroup::ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPrecis
     if (LiquEx_size != 0)
     {
         int LIQU_h[] = {0x5551494C, static_cast<int>(sizeof(WMOLiquidHeader) + LiquEx_size + hlq->xtiles* hlq->ytiles)}; // "LIQU"
-        fwrite(LIQU_h, 4, 2, output);
+        out.putSpan(LIQU_h, 2);
 
         // according to WoW.Dev Wiki:
         uint32 liquidEntry;
@@ -542,14 +599,14 @@ int WMOGroup::ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPrecis
         llog << ":\nliquidEntry: " << liquidEntry << " type: " << hlq->type << " (root:" << rootWMO->liquidType << " group:" << liquidType << ")\n";
         llog.close(); */
 
-        fwrite(hlq, sizeof(WMOLiquidHeader), 1, output);
+        out.put(*hlq);
         // only need height values, the other values are unknown anyway
         for (uint32 i = 0; i < LiquEx_size / sizeof(WMOLiquidVert); ++i)
         {
-            fwrite(&LiquEx[i].height, sizeof(float), 1, output);
+            out.put(LiquEx[i].height);
         }
         // todo: compress to bit field
-        fwrite(LiquBytes, 1, hlq->xtiles * hlq->ytiles, output);
+        out.putSpan(LiquBytes, hlq->xtiles * hlq->ytiles);
     }
 
     return nColTriangles;
@@ -567,7 +624,7 @@ WMOGroup::~WMOGroup()
 }
 
 //WmoInstName is in the form MD5/name.wmo
-WMOInstance::WMOInstance(MPQFile& f, std::string& WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile)
+WMOInstance::WMOInstance(MPQFile& f, std::string const& WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<char>& dirBuffer)
 {
     pos = Vec3D(0, 0, 0);
 
@@ -589,23 +646,14 @@ WMOInstance::WMOInstance(MPQFile& f, std::string& WmoInstName, uint32 mapID, uin
 
     //-----------add_in _dir_file----------------
 
-    char tempname[512];
-    sprintf(tempname, "%s/%s", szWorkDirWmo, WmoInstName.c_str());
-    FILE* input;
-    input = fopen(tempname, "r+b");
-
-    if (!input)
+    int nVertices = GetModelVertexCount(WmoInstName);
+    if (nVertices < 0)
     {
-        printf("WMOInstance::WMOInstance: couldn't open %s\n", tempname);
+        printf("WMOInstance::WMOInstance: couldn't open %s/%s\n", szWorkDirWmo, WmoInstName.c_str());
         return;
     }
 
-    fseek(input, 8, SEEK_SET); // get the correct no of vertices
-    int nVertices;
-    size_t file_read = fread(&nVertices, sizeof(int), 1, input);
-    fclose(input);
-
-    if (nVertices == 0 || file_read <= 0)
+    if (nVertices == 0)
     {
         return;
     }
@@ -629,38 +677,34 @@ WMOInstance::WMOInstance(MPQFile& f, std::string& WmoInstName, uint32 mapID, uin
         flags |= MOD_WORLDSPAWN;
     }
     //write mapID, tileX, tileY, Flags, ID, Pos, Rot, Scale, Bound_lo, Bound_hi, name
-    fwrite(&mapID, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileX, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileY, sizeof(uint32), 1, pDirfile);
-    fwrite(&flags, sizeof(uint32), 1, pDirfile);
-    fwrite(&adtId, sizeof(uint16), 1, pDirfile);
-    fwrite(&id, sizeof(uint32), 1, pDirfile);
-    fwrite(&pos, sizeof(float), 3, pDirfile);
-    fwrite(&rot, sizeof(float), 3, pDirfile);
-    fwrite(&scale, sizeof(float), 1, pDirfile);
-    fwrite(&pos2, sizeof(float), 3, pDirfile);
-    fwrite(&pos3, sizeof(float), 3, pDirfile);
+    BinaryWriter out(dirBuffer);
+    out.put(mapID);
+    out.put(tileX);
+    out.put(tileY);
+    out.put(flags);
+    out.put(adtId);
+    out.put(id);
+    out.put(pos);
+    out.put(rot);
+    out.put(scale);
+    out.put(pos2);
+    out.put(pos3);
     uint32 nlen = WmoInstName.length();
-    fwrite(&nlen, sizeof(uint32), 1, pDirfile);
-    fwrite(WmoInstName.c_str(), sizeof(char), nlen, pDirfile);
+    out.put(nlen);
+    out.putSpan(WmoInstName.c_str(), nlen);
+    g_placementsWritten.add(1);
 
 }
 
-bool ExtractSingleWmo(std::string& fname, int iCoreNumber, const void *szRawVMAPMagic)
+/**
+ * @brief Whether a uniform WMO name is a group file (name_NNN.wmo) rather than a root
+ *
+ * @param plain_name
+ * @return bool
+ */
+static bool IsWmoGroupFile(std::string const& plain_name)
 {
-    // Copy files from archive
-    char szLocalFile[1024];
-    string plain_name = GetUniformName(fname);
-
-    sprintf(szLocalFile, "%s/%s", szWorkDirWmo, plain_name.c_str());
-
-    if (FileExists(szLocalFile))
-    {
-        return true;
-    }
-
     int p = 0;
-    //Select root wmo files
     const char* rchr = strrchr(plain_name.c_str(), '_');
     if (rchr != NULL)
     {
@@ -683,25 +727,46 @@ bool ExtractSingleWmo(std::string& fname, int iCoreNumber, const void *szRawVMAP
         }
     }
 
-    if (p == 3)
+    return p == 3;
+}
+
+/**
+ * @brief Opens and converts one group of a job into its buffer
+ *
+ * @param job
+ * @param index
+ */
+static void ConvertWmoGroup(WmoGroupJob& job, uint32 index)
+{
+    char groupFileName[1024];
+    snprintf(groupFileName, sizeof(groupFileName), "%s_%03d.wmo", job.baseName.c_str(), index);
+    string s(groupFileName);
+
+    WmoGroupJob::Group& group = job.groups[index];
+    WMOGroup fgroup(s);
+    group.ok = fgroup.open();
+    if (group.ok)
     {
-        return true;
+        group.nVertices = fgroup.ConvertToVMAPGroupWmo(group.data, job.rootWMO, preciseVectorData, job.iCoreNumber);
     }
+}
 
+/**
+ * @brief Converts one root WMO and its groups into szLocalFile
+ *
+ * @return bool false if the output file could not be created
+ */
+static bool ConvertWmo(std::string& fname, std::string const& plain_name, char const* szLocalFile, WorkerPool& pool, int iCoreNumber, const void *szRawVMAPMagic)
+{
     bool file_ok = true;
     printf(" Extracting %s\n", fname.c_str());
-
-    HANDLE wmoHandle;
-
-    if (!OpenNewestFile(fname.c_str(), &wmoHandle))
-    {
-        printf("Error opening WMO file %s\n", fname.c_str());
-    }
+    TraceScope trace("wmo convert");
 
     WMORoot froot(fname);
     if (!froot.open())
     {
         printf("Couldn't open RootWmo!!!\n");
+        SetModelVertexCount(plain_name, -1);
         return true;
     }
 
@@ -709,39 +774,58 @@ bool ExtractSingleWmo(std::string& fname, int iCoreNumber, const void *szRawVMAP
     if (!output)
     {
         printf("Couldn't open %s for writing!\n", szLocalFile);
+        SetModelVertexCount(plain_name, -1);
         return false;
     }
 
-    froot.ConvertToVMAPRootWmo(output,szRawVMAPMagic);
+    BinaryWriter out(t_writeBuffer, output);
+    froot.ConvertToVMAPRootWmo(out, szRawVMAPMagic);
     int Wmo_nVertices = 0;
     if (froot.nGroups != 0)
     {
+        char temp[1024];
+        strncpy(temp, fname.c_str(), sizeof(temp) - 1);
+        temp[sizeof(temp) - 1] = '\0';
+        if (fname.length() >= 4)
+            temp[fname.length() - 4] = '\0';
+
+        // Idle workers take groups of a large root, so it does not hold up
+        // the end of the pass on its own.
+        WmoGroupJob job(temp, &froot, iCoreNumber, froot.nGroups);
+        WorkerPool::TaskGroup groupTasks;
+        for (uint32 i = 0; i < froot.nGroups; ++i)
+        {
+            WmoGroupJob* groupJob = &job;
+            pool.submit([groupJob, i]() { ConvertWmoGroup(*groupJob, i); }, groupTasks);
+        }
+        pool.wait(groupTasks);
+
+        // Write in group order, whichever thread converted which group
         for (uint32 i = 0; i < froot.nGroups; ++i)
         {
-            char temp[1024];
-            strncpy(temp, fname.c_str(), sizeof(temp) - 1);
-            temp[sizeof(temp) - 1] = '\0';
-            if (fname.length() >= 4)
-                temp[fname.length() - 4] = '\0';
-            char groupFileName[1024];
-            sprintf(groupFileName, "%s_%03d.wmo", temp, i);
-
-            string s(groupFileName);
-
-            WMOGroup fgroup(s);
-            if (!fgroup.open())
+            WmoGroupJob::Group const& group = job.groups[i];
+            if (!group.ok)
             {
                 printf("Could not open all Group file for: %s\n", plain_name.c_str());
                 file_ok = false;
                 break;
             }
 
-            Wmo_nVertices += fgroup.ConvertToVMAPGroupWmo(output, &froot, preciseVectorData, iCoreNumber);
+            out.putSpan(group.data.data(), group.data.size());
+            Wmo_nVertices += group.nVertices;
+            g_wmoGroupsConverted.add(1);
         }
     }
 
+    if (!out.flush())
+    {
+        printf("Error while writing %s\n", szLocalFile);
+        file_ok = false;
+    }
     fseek(output, 8, SEEK_SET); // store the correct no of vertices
     fwrite(&Wmo_nVertices, sizeof(int), 1, output);
+    fseek(output, 0, SEEK_END);
+    g_bytesWritten.add(uint64(ftell(output)));
     fclose(output);
 
     // Delete the extracted file in the case of an error
@@ -749,16 +833,58 @@ bool ExtractSingleWmo(std::string& fname, int iCoreNumber, const void *szRawVMAP
     {
         remove(szLocalFile);
     }
+    SetModelVertexCount(plain_name, file_ok ? Wmo_nVertices : -1);
+    if (file_ok)
+    {
+        g_wmosConverted.add(1);
+        journalFile(plain_name);
+    }
     return true;
 }
 
+bool ExtractSingleWmo(std::string& fname, WorkerPool& pool, int iCoreNumber, const void *szRawVMAPMagic)
+{
+    // Copy files from archive
+    char szLocalFile[1024];
+    string plain_name = GetUniformName(fname);
+
+    sprintf(szLocalFile, "%s/%s", szWorkDirWmo, plain_name.c_str());
+
+    //Select root wmo files
+    if (IsWmoGroupFile(plain_name))
+    {
+        return true;
+    }
+
+    std::promise<bool> extracted;
+    bool result;
+    if (!s_wmoExtracts.claim(plain_name, extracted, result, "wmo wait"))
+    {
+        return result;
+    }
+
+    // Left over from a previous run
+    if (FileExists(szLocalFile))
+    {
+        extracted.set_value(true);
+        return true;
+    }
+
+    bool ok = ConvertWmo(fname, plain_name, szLocalFile, pool, iCoreNumber, szRawVMAPMagic);
+    extracted.set_value(ok);
+    return ok;
+}
+
 bool ExtractWmo(int iCoreNumber, const void *szRawVMAPMagic)
 {
     bool success = true;
 
-    // Extract WMO in the reverse-order of the MPQ priority (ensure the highest priority WMO is erasing others)
-
-    for (ArchiveSet::reverse_iterator ar_itr = gOpenArchives.rbegin(); ar_itr != gOpenArchives.rend() && success; ++ar_itr)
+    // Gather the root WMOs first. Archives are walked from the highest priority
+    // down and the first spelling of a uniform name wins, as it did when each
+    // file was extracted as soon as it was found.
+    std::vector<std::string> roots;
+    std::set<std::string> seen;
+    for (ArchiveSet::reverse_iterator ar_itr = gOpenArchives.rbegin(); ar_itr != gOpenArchives.rend(); ++ar_itr)
     {
         SFILE_FIND_DATA data;
         HANDLE find = SFileFindFirstFile(*ar_itr, "*.wmo", &data, NULL);
@@ -767,12 +893,30 @@ bool ExtractWmo(int iCoreNumber, const void *szRawVMAPMagic)
             do
             {
                 std::string str = data.cFileName;
-                printf("Extracting wmo %s\n", str.c_str());
-                success |= ExtractSingleWmo(str, iCoreNumber, szRawVMAPMagic);
+                std::string plain_name = GetUniformName(str);
+                if (!IsWmoGroupFile(plain_name) && seen.insert(plain_name).second)
+                {
+                    roots.push_back(data.cFileName);
+                }
             } while (SFileFindNextFile(find, &data));
         }
         SFileFindClose(find);
     }
+    printf(" Found %u root WMOs\n", uint32(roots.size()));
+
+    // A failed root is reported by ExtractSingleWmo and, as before, does not
+    // stop the run.
+    WorkerPool pool(CONF_threads);
+    for (uint32 i = 0; i < roots.size(); ++i)
+    {
+        std::string* root = &roots[i];
+        WorkerPool* rootPool = &pool;
+        pool.submit([root, rootPool, iCoreNumber, szRawVMAPMagic]()
+        {
+            ExtractSingleWmo(*root, *rootPool, iCoreNumber, szRawVMAPMagic);
+        });
+    }
+    pool.wait();
 
     if (success)
     {
@@ -30,9 +30,13 @@
 
 #include <string>
 #include <set>
+#include <vector>
 #include "vec3d.h"
 #include <mpq.h>
 #include <loadlib.h>
+#include <BinaryWriter.h>
+
+class WorkerPool;
 
 // MOPY flags
 #define WMO_MATERIAL_NOCAMCOLLIDE    0x01
@@ -86,10 +90,10 @@ class WMORoot
         /**
          * @brief
          *
-         * @param output
+         * @param out
          * @return bool
          */
-        bool ConvertToVMAPRootWmo(FILE* output, const void *szRawVMAPMagic);
+        bool ConvertToVMAPRootWmo(BinaryWriter& out, const void *szRawVMAPMagic);
     private:
         std::string filename; /**< WMO filename for this group */
 };
@@ -182,12 +186,12 @@ class WMOGroup
         /**
          * @brief
          *
-         * @param output
+         * @param output buffer the group chunk is appended to
          * @param rootWMO
          * @param pPreciseVectorData
-         * @return int
+         * @return int number of collision triangles written
          */
-        int ConvertToVMAPGroupWmo(FILE* output, WMORoot* rootWMO, bool pPreciseVectorData, int iCoreNumber);
+        int ConvertToVMAPGroupWmo(std::vector<char>& output, WMORoot* rootWMO, bool pPreciseVectorData, int iCoreNumber);
 
     private:
         std::string filename; /**< WMO filename for this group */
@@ -219,9 +223,9 @@ class WMOInstance
          * @param mapID
          * @param tileX
          * @param tileY
-         * @param pDirfile
+         * @param dirBuffer
          */
-        WMOInstance(MPQFile& f, std::string& WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile);
+        WMOInstance(MPQFile& f, std::string const& WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<char>& dirBuffer);
 
         /**
          * @brief
@@ -234,9 +238,10 @@ class WMOInstance
  * @brief
  *
  * @param fname
+ * @param pool converts the groups of the root; may be the pool running the caller
  * @return bool
  */
-bool ExtractSingleWmo(std::string& fname, int iCoreNumber, const void *szRawVMAPMagic);
+bool ExtractSingleWmo(std::string& fname, WorkerPool& pool, int iCoreNumber, const void *szRawVMAPMagic);
 
 /**
  * @brief